@@ -0,0 +1,253 @@
+// bench.cpp - host benchmark of the game core (HOST_BUILD)
+//
+// Times update_physics(), render() and the refresh packing against the host
+// HAL, plus the brick collision test at larger brick counts. Numbers are host
+// numbers: compare them before/after a change on the same machine, don't read
+// them as device budgets. Built twice, for fixed-point and float physics.
+
+#include "game_classes.h"
+#include <chrono>
+#include <cstdio>
+
+static Hub75Matrix matrix;
+
+static double now_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Calls per second of fn, run in batches for at least MIN_SECONDS
+static constexpr double MIN_SECONDS = 0.5;
+
+template <typename F>
+static double rate(F fn) {
+    long calls = 0;
+    long batch = 64;
+    double start = now_s();
+    double elapsed;
+    do {
+        for (long i = 0; i < batch; ++i) fn();
+        calls += batch;
+        batch *= 2;
+        elapsed = now_s() - start;
+    } while (elapsed < MIN_SECONDS);
+    return calls / elapsed;
+}
+
+// Keep the paddle under the ball, hitting it off-centre in a slow cycle so
+// the deflection varies, and restart levels/games as they end
+struct Autopilot {
+    BrickBreaker &g;
+    uint32_t step;
+
+    void tick() {
+        GameEvent ev;
+        while (g.events.pop(ev)) {}
+        if (g.is_game_over()) g.reset_game();
+        if (g.is_level_cleared()) g.advance_level();
+        int offset = (int)(step++ / 97 % 5) - 2;
+        int x = floor_to_int(g.ball_x) - g.paddle_w / 2 + offset;
+        if (x < 0) x = 0;
+        if (x > BrickBreaker::WIDTH - g.paddle_w) x = BrickBreaker::WIDTH - g.paddle_w;
+        g.paddle_x = x;
+    }
+};
+
+static void bench_physics(BrickBreaker &g) {
+    static const struct { const char *name; bool index, swept; } variants[] = {
+        { "index, swept", true, true },
+        { "scan, swept", false, true },
+        { "index, step", true, false },
+        { "scan, step", false, false },
+    };
+    for (const auto &v : variants) {
+        g.use_brick_index = v.index;
+        g.swept_collision = v.swept;
+        g.reset_game();
+        Autopilot ap = { g, 0 };
+        double r = rate([&] { ap.tick(); g.update_physics(); });
+        printf("update_physics  %-22s %12.0f steps/s\n", v.name, r);
+    }
+    g.use_brick_index = true;
+    g.swept_collision = true;
+}
+
+static void bench_render(BrickBreaker &g) {
+    for (int layered = 1; layered >= 0; --layered) {
+        g.layered_render = layered;
+        g.reset_game();
+        Autopilot ap = { g, 0 };
+        // physics moves the ball between frames but is timed separately above
+        double render_s = 0;
+        long frames = 0;
+        double start = now_s();
+        while (now_s() - start < MIN_SECONDS) {
+            ap.tick();
+            g.update_physics();
+            double t0 = now_s();
+            g.render();
+            render_s += now_s() - t0;
+            frames++;
+        }
+        printf("render          %-22s %12.0f frames/s\n", layered ? "layered" : "full redraw", frames / render_s);
+    }
+    g.layered_render = true;
+}
+
+#if !HUB75_PALETTE_FB
+// Baseline for the packed refresh: the scan-out the pre-packed GPIO words
+// replaced. Every plane of every frame extracts each pixel's bits again and
+// writes the data pins with a clear and a set per column; the row address
+// is built bit by bit. Same planes, dwell and bit selection as refresh_once().
+// Without PINS the words are only computed, which is the per-frame work the
+// packed rows save; the host GPIO stand-in costs more than the real SIO does.
+static volatile uint32_t extract_sink;
+
+template <bool PINS>
+static void scan_out_per_pixel(const uint8_t (*frame)[Hub75Matrix::WIDTH][3], int planes, int dwell_us) {
+    typedef Hub75Matrix M;
+    uint32_t sum = 0;
+    for (int plane = planes - 1; plane >= 0; --plane) {
+        int bit = 8 - planes + plane;
+        int us = (1 << plane) * dwell_us;
+        for (int row = 0; row < M::SCAN_ROWS; ++row) {
+            if (PINS) hal_gpio_set_mask(M::M_OE);
+            uint32_t addr = 0;
+            for (int a = 0; a < M::ADDR_PINS; ++a) {
+                if ((row >> a) & 1) addr |= 1u << Hub75Config32x32::Pins::ADDR[a];
+            }
+            if (PINS) hal_gpio_put_masked(M::ADDR_MASK, addr);
+            else sum += addr;
+            for (int col = 0; col < M::WIDTH; ++col) {
+                const uint8_t *top = frame[row][col], *bot = frame[row + M::SCAN_ROWS][col];
+                uint32_t set_mask = 0;
+                if ((top[0] >> bit) & 1) set_mask |= M::M_R1;
+                if ((top[1] >> bit) & 1) set_mask |= M::M_G1;
+                if ((top[2] >> bit) & 1) set_mask |= M::M_B1;
+                if ((bot[0] >> bit) & 1) set_mask |= M::M_R2;
+                if ((bot[1] >> bit) & 1) set_mask |= M::M_G2;
+                if ((bot[2] >> bit) & 1) set_mask |= M::M_B2;
+                if (!PINS) {
+                    sum += set_mask;
+                    continue;
+                }
+                hal_gpio_clr_mask(M::DATA_MASK);
+                if (set_mask) hal_gpio_set_mask(set_mask);
+                hal_gpio_set_mask(M::M_CLK);
+                hal_gpio_clr_mask(M::M_CLK);
+            }
+            if (!PINS) continue;
+            hal_gpio_set_mask(M::M_LAT);
+            hal_busy_wait_us(1);
+            hal_gpio_clr_mask(M::M_LAT);
+            hal_gpio_clr_mask(M::M_OE);
+            hal_busy_wait_us(us);
+            hal_gpio_set_mask(M::M_OE);
+        }
+    }
+    extract_sink = sum;
+}
+#endif
+
+// refresh_once() after each rendered frame: in PIO mode that is packing only
+// the rows the frame touched into the engine's plane buffers; inline it is a
+// repack of the GPIO words plus a scan-out with the dwell skipped. per-pixel
+// is the same inline scan-out without packed words, for comparison.
+static void bench_refresh(BrickBreaker &g) {
+    hal_host_skip_waits(true);
+    for (int pio = 1; pio >= 0; --pio) {
+        if (pio) matrix.start_pio_refresh();
+        for (int layered = 1; layered >= 0; --layered) {
+            g.layered_render = layered;
+            g.reset_game();
+            Autopilot ap = { g, 0 };
+            double refresh_s = 0;
+            long frames = 0;
+            double start = now_s();
+            while (now_s() - start < MIN_SECONDS) {
+                ap.tick();
+                g.update_physics();
+                g.render();
+                double t0 = now_s();
+                matrix.refresh_once();
+                refresh_s += now_s() - t0;
+                frames++;
+            }
+            char name[32];
+            snprintf(name, sizeof(name), "%s, %s", pio ? "pio pack" : "inline", layered ? "layered" : "full redraw");
+            printf("refresh_once    %-22s %12.2f us/frame\n", name, refresh_s * 1e6 / frames);
+        }
+        if (pio) matrix.stop_pio_refresh();
+    }
+#if !HUB75_PALETTE_FB
+    for (int variant = 0; variant < 4; ++variant) {
+        bool pins = variant < 2, layered = !(variant & 1);
+        g.layered_render = layered;
+        g.reset_game();
+        Autopilot ap = { g, 0 };
+        Hub75PanelBase::RefreshTiming t = matrix.refresh_timing();
+        double refresh_s = 0;
+        long frames = 0;
+        double start = now_s();
+        while (now_s() - start < MIN_SECONDS) {
+            ap.tick();
+            g.update_physics();
+            g.render();
+            double t0 = now_s();
+            if (pins) scan_out_per_pixel<true>(matrix.fb, t.planes, t.dwell_us);
+            else scan_out_per_pixel<false>(matrix.fb, t.planes, t.dwell_us);
+            refresh_s += now_s() - t0;
+            frames++;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%s, %s", pins ? "per-pixel" : "extract", layered ? "layered" : "full redraw");
+        printf("refresh_once    %-22s %12.2f us/frame\n", name, refresh_s * 1e6 / frames);
+    }
+#endif
+    hal_host_skip_waits(false);
+    g.layered_render = true;
+}
+
+// Brick collision alone at brick counts the game doesn't reach yet: a wall of
+// cols x rows bricks of w x h from the top, a full-width paddle at the bottom
+static void bench_bricks(int cols, int rows, int w, int h, int gap) {
+    static Brick bricks[512];
+    static BrickIndex index;
+    const int n = cols * rows;
+    auto build = [&] {
+        for (int i = 0; i < n; ++i) {
+            bricks[i].x = (i % cols) * (w + gap);
+            bricks[i].y = (i / cols) * (h + gap);
+            bricks[i].alive = true;
+        }
+        index.build(bricks, n, w, h);
+    };
+    const PaddleBox paddle = { 0, BrickBreaker::HEIGHT - 2, BrickBreaker::WIDTH, 2 };
+    for (int use_index = 1; use_index >= 0; --use_index) {
+        build();
+        BallState<phys_t> ball = { phys_t(15.0f), phys_t(26.0f), phys_t(0.7f), phys_t(-1.3f) };
+        double r = rate([&] {
+            StepResult res = step_ball_swept(ball, BrickBreaker::WIDTH, BrickBreaker::HEIGHT, paddle, bricks, n,
+                                             w, h, use_index ? &index : nullptr);
+            if (res.level_cleared || res.fell) {
+                build();
+                ball = { phys_t(15.0f), phys_t(26.0f), phys_t(0.7f), phys_t(-1.3f) };
+            }
+        });
+        char name[32];
+        snprintf(name, sizeof(name), "%d bricks, %s", n, use_index ? "index" : "scan");
+        printf("step_ball_swept %-22s %12.0f steps/s\n", name, r);
+    }
+}
+
+int main() {
+    printf("brick bench: %s physics, %s framebuffer\n", BRICK_FIXED_POINT ? "Q16.16 fixed-point" : "float",
+           HUB75_PALETTE_FB ? "4-bit palette" : "RGB888");
+    static BrickBreaker game(matrix);
+    bench_physics(game);
+    bench_render(game);
+    bench_refresh(game);
+    bench_bricks(6, 4, 4, 2, 1);
+    bench_bricks(16, 8, 2, 1, 0);
+    bench_bricks(32, 16, 1, 1, 0);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// replay.cpp - replay a recorded session on the host as fast as it runs
+//
+//   brick_replay [-r] <serial log> [repeat]
+//
+// Loads the first dump in the log (key '#' on the device, see
+// input_record.h), plays it through BrickBreaker 'repeat' times and reports
+// the speed and any keyframe that didn't match. -r also renders and packs
+// every tick, for profiling the whole frame. Exits 1 on a divergence, so a
+// saved session doubles as a regression test for the physics.
+
+#include "input_record.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static Hub75Matrix matrix;
+static uint8_t data[InputRecorder::RING_SIZE];
+
+int main(int argc, char **argv) {
+    int arg = 1;
+    bool render = false;
+    if (arg < argc && strcmp(argv[arg], "-r") == 0) {
+        render = true;
+        arg++;
+    }
+    if (arg >= argc) {
+        fprintf(stderr, "usage: %s [-r] <serial log> [repeat]\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[arg], "r");
+    if (!f) {
+        perror(argv[arg]);
+        return 2;
+    }
+    uint32_t len = input_load_dump(f, data, sizeof(data));
+    fclose(f);
+    if (!len) {
+        fprintf(stderr, "%s: no recording made by a %s-physics build\n", argv[arg],
+                BRICK_FIXED_POINT ? "fixed-point" : "float");
+        return 2;
+    }
+    int repeat = arg + 1 < argc ? atoi(argv[arg + 1]) : 1;
+    if (repeat < 1) repeat = 1;
+
+    static BrickBreaker game(matrix);
+    JoystickPaddle joy;
+    if (render) matrix.start_pio_refresh();
+    InputReplay::Stats st = {};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        InputReplay r(data, len, 0, len);
+        if (!r.begin(game, joy)) {
+            fprintf(stderr, "recording doesn't start with a keyframe\n");
+            return 2;
+        }
+        uint16_t raw;
+        while (r.next_tick(game, joy, raw)) {
+            game_tick(game, joy, raw);
+            GameEvent ev;
+            while (game.events.pop(ev)) {}
+            if (render) {
+                game.render();
+                matrix.refresh_once();
+            }
+        }
+        st = r.stats();
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double span = (st.last_ms - st.first_ms) / 1000.0;
+
+    printf("recording: %lu bytes, %.1f s, %lu ticks, %lu keys, %lu keyframes\n", (unsigned long)len, span,
+           (unsigned long)st.ticks, (unsigned long)st.keys, (unsigned long)st.keyframes);
+    printf("replayed %d time%s%s in %.3f s: %.0f ticks/s, %.0fx real time\n", repeat, repeat == 1 ? "" : "s",
+           render ? " with rendering" : "", wall, st.ticks * (double)repeat / wall, span * repeat / wall);
+    printf("end: level %d, score %d, lives %d\n", game.level, game.score, game.lives);
+    if (st.diverged) {
+        printf("%lu of %lu keyframes diverged\n", (unsigned long)st.diverged, (unsigned long)st.keyframes);
+        return 1;
+    }
+    printf("all keyframes matched\n");
+    return 0;
+}
@@ -0,0 +1,181 @@
+// scalar_diff.cpp - fixed-point vs float ball physics in lockstep
+//
+//   brick_scalar_diff [-n runs] [-t ticks] [--step]
+//
+// Steps BallState<Fixed> and BallState<float> from the same starting state,
+// each against its own copy of the level-1 bricks, with one scripted paddle
+// (it follows the float ball) shared by both. Per run it prints the first
+// tick the positions are more than DRIFT_PX apart, the first tick the two
+// ticks' outcomes differ (walls, paddle, bricks hit, fall), and the largest
+// position error up to then; after that the two games are simply different
+// games. Starts vary the speed scale (the three Difficulty values) and angle.
+// Then each scalar plays every start again on its own, the paddle following
+// its own ball, and the steps per second of both are printed side by side.
+// --step compares step_ball instead of step_ball_swept.
+
+#include "game_classes.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static constexpr float DRIFT_PX = 0.01f;
+static constexpr int TIMING_REPEATS = 100;
+static constexpr int N_BRICKS = BrickBreaker::brick_rows * BrickBreaker::brick_cols;
+
+static Hub75Matrix matrix;
+
+struct Side {
+    Brick bricks[N_BRICKS];
+    BrickIndex index;
+};
+
+template <typename S>
+static StepResult step(bool swept, BallState<S> &ball, const PaddleBox &paddle, Brick *bricks, BrickIndex &index) {
+    return swept ? step_ball_swept(ball, BrickBreaker::WIDTH, BrickBreaker::HEIGHT, paddle, bricks, N_BRICKS,
+                                   BrickBreaker::brick_w, BrickBreaker::brick_h, &index)
+                 : step_ball(ball, BrickBreaker::WIDTH, BrickBreaker::HEIGHT, paddle, bricks, N_BRICKS,
+                             BrickBreaker::brick_w, BrickBreaker::brick_h, &index);
+}
+
+// Under the ball, hitting it off-centre in a slow cycle
+static PaddleBox scripted_paddle(const BrickBreaker &level, float ball_x, int tick) {
+    int px = floor_to_int(ball_x) - level.paddle_w / 2 + (tick / 53 % 5) - 2;
+    if (px < 0) px = 0;
+    if (px > BrickBreaker::WIDTH - level.paddle_w) px = BrickBreaker::WIDTH - level.paddle_w;
+    return { px, level.paddle_y, level.paddle_w, level.paddle_h };
+}
+
+static bool same_outcome(const StepResult &a, const StepResult &b) {
+    if (a.wall_bounces != b.wall_bounces || a.paddle_hit != b.paddle_hit || a.n_brick_hits != b.n_brick_hits ||
+        a.level_cleared != b.level_cleared || a.fell != b.fell) {
+        return false;
+    }
+    return memcmp(a.brick_hits, b.brick_hits, a.n_brick_hits * sizeof(a.brick_hits[0])) == 0;
+}
+
+struct RunDiff {
+    int ticks;       // ticks stepped
+    int drift_tick;  // first tick over DRIFT_PX, -1 if none
+    int split_tick;  // first tick with a different outcome, -1 if none
+    float max_err;   // largest position error before split_tick
+    int bricks_hit;  // by the fixed-point side before split_tick
+};
+
+static RunDiff run(const BrickBreaker &level, float speed, float vx, float vy, int max_ticks, bool swept) {
+    static Side q, f;
+    Side *sides[2] = { &q, &f };
+    for (Side *s : sides) {
+        memcpy(s->bricks, level.bricks, sizeof(s->bricks));
+        s->index.build(s->bricks, N_BRICKS, BrickBreaker::brick_w, BrickBreaker::brick_h);
+    }
+    float x0 = (float)level.ball_x, y0 = (float)level.ball_y;
+    BallState<Fixed> bq = { Fixed(x0), Fixed(y0), Fixed(vx * speed), Fixed(vy * speed) };
+    BallState<float> bf = { x0, y0, vx * speed, vy * speed };
+
+    RunDiff d = { 0, -1, -1, 0.0f, 0 };
+    for (int tick = 0; tick < max_ticks; ++tick) {
+        PaddleBox paddle = scripted_paddle(level, bf.x, tick);
+
+        StepResult rq = step(swept, bq, paddle, q.bricks, q.index);
+        StepResult rf = step(swept, bf, paddle, f.bricks, f.index);
+        d.ticks++;
+        float err = hypotf((float)bq.x - bf.x, (float)bq.y - bf.y);
+        if (!same_outcome(rq, rf)) {
+            d.split_tick = tick;
+            break;
+        }
+        d.bricks_hit += rq.n_brick_hits;
+        if (err > d.max_err) d.max_err = err;
+        if (d.drift_tick < 0 && err > DRIFT_PX) d.drift_tick = tick;
+        if (rq.level_cleared || rq.fell) break;
+    }
+    return d;
+}
+
+struct Start {
+    float speed, vx, vy;
+};
+
+// Starts vary the speed scale and spread the launch angle over +-60 degrees
+// from straight up
+static Start start(int r, int runs) {
+    static const float speeds[] = { 0.5f, 1.0f, 1.8f };
+    float a = (-60.0f + 120.0f * (r / 3 + 0.5f) / ((runs + 2) / 3)) * 3.14159265f / 180.0f;
+    return { speeds[r % 3], 1.72f * sinf(a), -1.72f * cosf(a) };
+}
+
+// Plays every start for max_ticks with one scalar (relaunching after a fall
+// or a cleared level) and returns its steps per second
+template <typename S>
+static double steps_per_sec(const BrickBreaker &level, int runs, int max_ticks, bool swept, long &steps) {
+    static Side side;
+    volatile int sink = 0;
+    steps = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < TIMING_REPEATS; ++rep) {
+        for (int r = 0; r < runs; ++r) {
+            Start st = start(r, runs);
+            BallState<S> ball = {};
+            bool launch = true;
+            for (int tick = 0; tick < max_ticks; ++tick) {
+                if (launch) {
+                    memcpy(side.bricks, level.bricks, sizeof(side.bricks));
+                    side.index.build(side.bricks, N_BRICKS, BrickBreaker::brick_w, BrickBreaker::brick_h);
+                    ball = { S((float)level.ball_x), S((float)level.ball_y), S(st.vx * st.speed),
+                             S(st.vy * st.speed) };
+                    launch = false;
+                }
+                PaddleBox paddle = scripted_paddle(level, (float)ball.x, tick);
+                StepResult res = step(swept, ball, paddle, side.bricks, side.index);
+                sink += res.n_brick_hits;
+                launch = res.level_cleared || res.fell;
+            }
+            steps += max_ticks;
+        }
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    (void)sink;
+    return steps / s;
+}
+
+int main(int argc, char **argv) {
+    int runs = 12, max_ticks = 5000;
+    bool swept = true;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--step") == 0) swept = false;
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) max_ticks = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-n runs] [-t ticks] [--step]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static BrickBreaker level(matrix);
+    printf("%s: Q16.16 vs float from the same start, drift = error over %.2f px\n",
+           swept ? "step_ball_swept" : "step_ball", DRIFT_PX);
+    printf("speed     vx     vy | ticks  drift  split | max err px  bricks\n");
+    int diverged = 0;
+    double worst = 0.0;
+    for (int r = 0; r < runs; ++r) {
+        Start st = start(r, runs);
+        RunDiff d = run(level, st.speed, st.vx, st.vy, max_ticks, swept);
+        char drift[16], split[16];
+        snprintf(drift, sizeof(drift), d.drift_tick < 0 ? "-" : "%d", d.drift_tick);
+        snprintf(split, sizeof(split), d.split_tick < 0 ? "-" : "%d", d.split_tick);
+        printf("%5.2f %6.2f %6.2f | %5d %6s %6s | %10.6f  %6d\n", st.speed, st.vx, st.vy, d.ticks, drift, split,
+               d.max_err, d.bricks_hit);
+        diverged += d.split_tick >= 0;
+        if (d.max_err > worst) worst = d.max_err;
+    }
+    printf("%d of %d runs split; largest error before a split %.6f px\n", diverged, runs, worst);
+
+    long q_steps, f_steps;
+    double q_rate = steps_per_sec<Fixed>(level, runs, max_ticks, swept, q_steps);
+    double f_rate = steps_per_sec<float>(level, runs, max_ticks, swept, f_steps);
+    printf("Q16.16: %ld steps, %.2f M steps/s\n", q_steps, q_rate / 1e6);
+    printf("float:  %ld steps, %.2f M steps/s (%.2fx Q16.16)\n", f_steps, f_rate / 1e6, f_rate / q_rate);
+    return 0;
+}
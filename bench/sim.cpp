@@ -0,0 +1,360 @@
+// sim.cpp - headless Monte-Carlo games for difficulty and speed tuning
+//
+//   brick_sim [-t threads] [-n runs] [-l levels] [-s seed] [--step] [--scaling]
+//             [--speed list] [--deflect list] [--sens list] [--smooth list]
+//             [--max-step list] [--deadzone list]
+//
+// Plays 'runs' games (default 200) for every combination of the listed ball
+// speed scales (what BrickBreaker::difficulty_speed gives a Difficulty),
+// paddle deflections and JoystickParams, lists being comma-separated. The
+// paddle goes through JoystickPaddle like the real stick: a scripted player
+// looks where the ball will come down every few ticks, picks a spot on the
+// paddle to take it on and holds a noisy stick there. A game ends at game
+// over, after 'levels' cleared levels (default 3), or when the ball is stuck.
+//
+// Per combination it reports seconds of play per cleared level (10th, 50th,
+// 90th percentile), lives lost per game, the share of games lost, and two
+// incident counts:
+//   tunnel  in a tick without a bounce the ball's path overlapped a live
+//           brick, or the paddle while falling
+//   stuck   STUCK_S seconds of play with no brick hit and no life lost
+// Every run is seeded from the seed, its combination and its number, so the
+// results don't depend on the thread count. --step uses the per-tick overlap
+// test instead of swept collision, to see what the swept test buys.
+// --scaling runs the sweep at 1, 2, 4... threads up to -t and prints the
+// speedup of each.
+
+#include "game_input.h"
+#include "work_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static constexpr double TICK_S = 0.040;   // PHYSICS_PERIOD_US in display_matrix.cpp
+static constexpr int STUCK_S = 60;
+static constexpr uint32_t STUCK_TICKS = (uint32_t)(STUCK_S / TICK_S);
+static constexpr int PATH_SAMPLES = 16;   // points tested along a tick's path
+static constexpr float TOUCH_EPS = 1e-3f; // touching isn't overlapping
+
+// The stick as calibrated at boot (12-bit ADC counts, 4 fraction bits)
+static constexpr uint16_t CAL_CENTER = 2048 << 4;
+static constexpr uint16_t CAL_RANGE = 2000 << 4;
+
+// Only render() draws into the matrix and the simulation never calls it, so
+// the games on all threads share this one
+static Hub75Matrix matrix;
+
+struct Config {
+    float speed;
+    float deflect;
+    JoystickParams joy;
+};
+
+struct RunResult {
+    std::vector<float> clear_s; // seconds of play per cleared level
+    uint32_t ticks;
+    uint32_t tunnels;
+    int lives_lost;
+    bool lost;                  // ended in game over
+    bool stuck;
+};
+
+// splitmix64: tiny, and fine seeded from consecutive integers
+struct Rng {
+    uint64_t s;
+
+    uint64_t next() {
+        uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    float uniform() { return (float)(next() >> 40) * (1.0f / 16777216.0f); } // [0, 1)
+    float range(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+};
+
+// Where the ball's left edge will be when it reaches the paddle, bouncing off
+// the walls (and the ceiling, if it's rising) but ignoring bricks
+static float landing_x(const BrickBreaker &g) {
+    float x = (float)g.ball_x, y = (float)g.ball_y;
+    float vx = (float)g.ball_vx, vy = (float)g.ball_vy;
+    float floor_y = (float)(g.paddle_y - 2);
+    if (vy == 0.0f) return x;
+    float t = vy > 0.0f ? (floor_y - y) / vy : (y + floor_y) / -vy;
+    if (t < 0.0f) t = 0.0f;
+    float span = (float)(BrickBreaker::WIDTH - 2);
+    float px = fmodf(x + vx * t, 2.0f * span);
+    if (px < 0.0f) px += 2.0f * span;
+    return px > span ? 2.0f * span - px : px;
+}
+
+// Scripted player: slow to react, imprecise and with a shaky hand, so the
+// stick tuning matters the way it does for a person
+struct Player {
+    Rng rng;
+    int reaction;     // ticks between looks at the ball
+    float jitter;     // stick noise, fraction of full deflection
+    float hit_offset; // where on the paddle it wants the ball, px from centre
+    int wait;
+    float stick;      // -1..1, positive = right
+
+    explicit Player(uint64_t seed) : rng{ seed } {
+        reaction = 2 + (int)(rng.next() % 5); // 80..240 ms
+        jitter = rng.range(0.01f, 0.06f);
+        hit_offset = 0.0f;
+        wait = 0;
+        stick = 0.0f;
+    }
+
+    uint16_t reading(const BrickBreaker &g, const JoystickParams &p) {
+        int max_x = BrickBreaker::WIDTH - g.paddle_w;
+        if (wait-- <= 0) {
+            wait = reaction;
+            if (g.ball_vy < phys_t(0.0f)) hit_offset = rng.range(-2.0f, 2.0f);
+            float aim = landing_x(g) + 1.0f - g.paddle_w * 0.5f - hit_offset;
+            if (aim < 0.0f) aim = 0.0f;
+            if (aim > (float)max_x) aim = (float)max_x;
+            // JoystickPaddle steers toward the position the stick points at;
+            // push past the aim by however far the paddle still is from it
+            float err = (aim - (float)g.paddle_x) / (float)max_x * 2.0f;
+            stick = aim / (float)max_x * 2.0f - 1.0f + err;
+            if (fabsf(stick) <= p.deadzone && fabsf(err) > 1.0f / max_x) {
+                stick = err > 0.0f ? p.deadzone + 0.05f : -p.deadzone - 0.05f;
+            }
+            stick = std::max(-1.0f, std::min(1.0f, stick));
+        }
+        float norm = stick + jitter * (rng.uniform() + rng.uniform() - 1.0f);
+        if (p.invert) norm = -norm;
+        int raw = CAL_CENTER + (int)(norm * CAL_RANGE);
+        return (uint16_t)std::max(0, std::min(0xFFFF, raw));
+    }
+};
+
+// Whether the 2x2 ball moving in a straight line from (x, y) by (dx, dy)
+// overlaps the box [x0, x1) x [y0, y1) at any of PATH_SAMPLES points
+static bool path_overlaps(float x, float y, float dx, float dy, float x0, float y0, float x1, float y1) {
+    for (int i = 1; i <= PATH_SAMPLES; ++i) {
+        float t = (float)i / PATH_SAMPLES;
+        float bx = x + dx * t, by = y + dy * t;
+        if (bx + 2.0f > x0 + TOUCH_EPS && bx < x1 - TOUCH_EPS && by + 2.0f > y0 + TOUCH_EPS &&
+            by < y1 - TOUCH_EPS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A tick that changed neither velocity nor lives moved the ball straight
+// through everything in its way: count it if that included a live brick or
+// (falling) the paddle
+static bool tunnelled(const BrickBreaker &g, const GameSnapshot &before) {
+    if (g.ball_vx != before.ball_vx || g.ball_vy != before.ball_vy) return false;
+    if (g.lives != before.lives || g.is_level_cleared()) return false;
+    float x = (float)before.ball_x, y = (float)before.ball_y;
+    float dx = (float)g.ball_x - x, dy = (float)g.ball_y - y;
+    for (int i = 0; i < BrickBreaker::brick_rows * BrickBreaker::brick_cols; ++i) {
+        if (!((before.bricks_alive >> i) & 1u)) continue;
+        const Brick &b = g.bricks[i];
+        if (path_overlaps(x, y, dx, dy, (float)b.x, (float)b.y, (float)(b.x + BrickBreaker::brick_w),
+                          (float)(b.y + BrickBreaker::brick_h))) {
+            return true;
+        }
+    }
+    return before.ball_vy > phys_t(0.0f) &&
+           path_overlaps(x, y, dx, dy, (float)g.paddle_x, (float)g.paddle_y, (float)(g.paddle_x + g.paddle_w),
+                         (float)(g.paddle_y + g.paddle_h));
+}
+
+static void play(const Config &c, uint64_t seed, int levels, bool swept, RunResult &r) {
+    BrickBreaker g(matrix);
+    g.swept_collision = swept;
+    g.difficulty_speed[BrickBreaker::MEDIUM] = phys_t(c.speed);
+    g.paddle_deflect = phys_t(c.deflect);
+    g.set_difficulty(BrickBreaker::MEDIUM);
+    JoystickPaddle joy(c.joy);
+    joy.calibrate(CAL_CENTER, CAL_RANGE);
+    joy.reset(g.paddle_x);
+    Player player(seed);
+
+    int start_lives = g.lives;
+    uint32_t level_ticks = 0, idle = 0;
+    r = RunResult();
+    while (!g.is_game_over()) {
+        GameEvent ev;
+        while (g.events.pop(ev)) {}
+        if (g.is_level_cleared()) {
+            r.clear_s.push_back((float)(level_ticks * TICK_S));
+            if ((int)r.clear_s.size() >= levels) break;
+            game_key(g, 'B');
+            level_ticks = idle = 0;
+            continue;
+        }
+        if (idle >= STUCK_TICKS) {
+            r.stuck = true;
+            break;
+        }
+        GameSnapshot before;
+        g.save(before);
+        game_tick(g, joy, player.reading(g, joy.params));
+        r.ticks++;
+        level_ticks++;
+        idle = g.score != before.score || g.lives != before.lives ? 0 : idle + 1;
+        if (tunnelled(g, before)) r.tunnels++;
+    }
+    r.lives_lost = start_lives - g.lives;
+    r.lost = g.is_game_over();
+}
+
+// All runs of all configs, results[config * runs + run]
+static void sweep(const std::vector<Config> &configs, int runs, int levels, uint64_t seed, bool swept,
+                  int threads, std::vector<RunResult> &results, uint64_t &steals) {
+    results.assign(configs.size() * runs, RunResult());
+    WorkPool pool(threads);
+    for (size_t c = 0; c < configs.size(); ++c) {
+        for (int i = 0; i < runs; ++i) {
+            size_t k = c * runs + i;
+            uint64_t run_seed = Rng{ seed ^ ((uint64_t)c << 32 | (uint32_t)i) }.next();
+            pool.submit([&, c, k, run_seed] { play(configs[c], run_seed, levels, swept, results[k]); });
+        }
+    }
+    pool.run();
+    steals = pool.steals();
+}
+
+static float percentile(const std::vector<float> &sorted, float q) {
+    if (sorted.empty()) return 0.0f;
+    return sorted[(size_t)(q * (sorted.size() - 1) + 0.5f)];
+}
+
+static void report(const std::vector<Config> &configs, int runs, const std::vector<RunResult> &results) {
+    printf("speed deflect  sens smooth  step    dz | levels  clear s p10   p50   p90 | lives lost%% | tunnel stuck\n");
+    for (size_t c = 0; c < configs.size(); ++c) {
+        const Config &cf = configs[c];
+        std::vector<float> clear;
+        int lives = 0, lost = 0, stuck = 0;
+        uint64_t tunnels = 0;
+        for (int i = 0; i < runs; ++i) {
+            const RunResult &r = results[c * runs + i];
+            clear.insert(clear.end(), r.clear_s.begin(), r.clear_s.end());
+            lives += r.lives_lost;
+            lost += r.lost;
+            stuck += r.stuck;
+            tunnels += r.tunnels;
+        }
+        std::sort(clear.begin(), clear.end());
+        printf("%5.2f %7.2f %5.2f %6.2f %5.1f %5.2f | %6zu %11.1f %5.1f %5.1f | %5.2f %4.0f%% | %6llu %5d\n", cf.speed,
+               cf.deflect, cf.joy.sensitivity, cf.joy.smooth, cf.joy.max_step, cf.joy.deadzone, clear.size(),
+               percentile(clear, 0.1f), percentile(clear, 0.5f), percentile(clear, 0.9f), (double)lives / runs,
+               100.0 * lost / runs, (unsigned long long)tunnels, stuck);
+    }
+}
+
+static uint64_t total_ticks(const std::vector<RunResult> &results) {
+    uint64_t n = 0;
+    for (const RunResult &r : results) n += r.ticks;
+    return n;
+}
+
+// Comma-separated floats
+static bool parse_list(const char *s, std::vector<float> &out) {
+    out.clear();
+    while (*s) {
+        char *end;
+        out.push_back(strtof(s, &end));
+        if (end == s) return false;
+        s = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return false;
+    }
+    return !out.empty();
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-t threads] [-n runs] [-l levels] [-s seed] [--step] [--scaling]\n"
+            "          [--speed list] [--deflect list] [--sens list] [--smooth list]\n"
+            "          [--max-step list] [--deadzone list]\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    int threads = 0, runs = 200, levels = 3;
+    uint64_t seed = 1;
+    bool swept = true, scaling = false;
+    std::vector<float> speed = { 0.5f, 0.75f, 1.0f, 1.4f, 1.8f, 2.4f };
+    std::vector<float> deflect = { 0.05f, 0.1f, PADDLE_DEFLECT, 0.25f };
+    std::vector<float> sens = { 0.2f, JOY_DEFAULT_PARAMS.sensitivity, 0.8f };
+    std::vector<float> smooth = { JOY_DEFAULT_PARAMS.smooth };
+    std::vector<float> max_step = { JOY_DEFAULT_PARAMS.max_step };
+    std::vector<float> deadzone = { JOY_DEFAULT_PARAMS.deadzone };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok = true;
+        if (a == "--step") swept = false;
+        else if (a == "--scaling") scaling = true;
+        else if (!v) ok = false;
+        else if (a == "-t") threads = atoi(v);
+        else if (a == "-n") runs = atoi(v);
+        else if (a == "-l") levels = atoi(v);
+        else if (a == "-s") seed = strtoull(v, nullptr, 0);
+        else if (a == "--speed") ok = parse_list(v, speed);
+        else if (a == "--deflect") ok = parse_list(v, deflect);
+        else if (a == "--sens") ok = parse_list(v, sens);
+        else if (a == "--smooth") ok = parse_list(v, smooth);
+        else if (a == "--max-step") ok = parse_list(v, max_step);
+        else if (a == "--deadzone") ok = parse_list(v, deadzone);
+        else ok = false;
+        if (!ok || runs < 1 || levels < 1) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (a != "--step" && a != "--scaling") ++i;
+    }
+
+    std::vector<Config> configs;
+    for (float sp : speed) for (float d : deflect) for (float se : sens) for (float sm : smooth)
+        for (float ms : max_step) for (float dz : deadzone) {
+            JoystickParams j = JOY_DEFAULT_PARAMS;
+            j.sensitivity = se;
+            j.smooth = sm;
+            j.max_step = ms;
+            j.deadzone = dz;
+            configs.push_back({ sp, d, j });
+        }
+
+    int max_threads = WorkPool(threads).threads();
+    std::vector<int> counts;
+    if (scaling) {
+        for (int t = 1; t < max_threads; t *= 2) counts.push_back(t);
+    }
+    counts.push_back(max_threads);
+
+    std::vector<RunResult> results;
+    double base_rate = 0.0;
+    uint64_t base_ticks = 0;
+    for (int t : counts) {
+        uint64_t steals;
+        auto start = std::chrono::steady_clock::now();
+        sweep(configs, runs, levels, seed, swept, t, results, steals);
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t ticks = total_ticks(results);
+        double rate = ticks / wall;
+        if (!base_rate) {
+            base_rate = rate;
+            base_ticks = ticks;
+        }
+        printf("%zu games, %.1f h of play in %.2f s on %d thread%s: %.0f ticks/s, %.2fx, %llu steals%s\n",
+               results.size(), ticks * TICK_S / 3600.0, wall, t, t == 1 ? "" : "s", rate, rate / base_rate,
+               (unsigned long long)steals, ticks == base_ticks ? "" : " (results differ!)");
+    }
+    printf("\n%s collision, %d run%s per row, up to %d level%s\n", swept ? "swept" : "per-tick", runs,
+           runs == 1 ? "" : "s", levels, levels == 1 ? "" : "s");
+    report(configs, runs, results);
+    return 0;
+}
@@ -0,0 +1,90 @@
+// work_pool.h - fixed set of worker threads with work stealing (host tools)
+//
+// Tasks are queued before run() and dealt round-robin into one deque per
+// worker. A worker takes from the back of its own deque and, once that is
+// empty, steals from the front of the others', so uneven tasks (a game that
+// lasts ten times longer than the next) don't leave cores idle at the end.
+// Tasks are coarse, so a mutex per deque costs nothing measurable.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkPool {
+public:
+    typedef std::function<void()> Task;
+
+    // threads < 1: one per hardware thread
+    explicit WorkPool(int threads = 0) {
+        if (threads < 1) threads = (int)std::thread::hardware_concurrency();
+        if (threads < 1) threads = 1;
+        for (int i = 0; i < threads; ++i) queues.emplace_back(new Queue);
+        next = 0;
+        stolen = 0;
+    }
+
+    int threads() const { return (int)queues.size(); }
+    // Tasks taken from another worker's deque in the last run()
+    uint64_t steals() const { return stolen; }
+
+    void submit(Task t) {
+        queues[next]->tasks.push_back(std::move(t));
+        next = (next + 1) % queues.size();
+    }
+
+    // Run everything submitted; returns when all of it is done
+    void run() {
+        stolen = 0;
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads(); ++i) workers.emplace_back([this, i] { work(i); });
+        work(0);
+        for (std::thread &t : workers) t.join();
+        next = 0;
+    }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+    size_t next;
+    std::atomic<uint64_t> stolen;
+
+    void work(int self) {
+        Task t;
+        while (take(self, t)) t();
+    }
+
+    bool take(int self, Task &t) {
+        {
+            Queue &q = *queues[self];
+            std::lock_guard<std::mutex> g(q.lock);
+            if (!q.tasks.empty()) {
+                t = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                return true;
+            }
+        }
+        // nothing is queued once run() starts, so all deques empty = done
+        int n = threads();
+        for (int k = 1; k < n; ++k) {
+            Queue &q = *queues[(self + k) % n];
+            std::lock_guard<std::mutex> g(q.lock);
+            if (!q.tasks.empty()) {
+                t = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                stolen++;
+                return true;
+            }
+        }
+        return false;
+    }
+};
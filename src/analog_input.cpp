@@ -0,0 +1,127 @@
+// analog_input.cpp - ADC free-running capture + DMA ring + decimation
+
+#include "analog_input.h"
+#include "hal.h"
+#include <cstring>
+
+#ifndef HOST_BUILD
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#endif
+
+// ADC clock is a fixed 48 MHz and a conversion takes 96 cycles
+static constexpr uint32_t ADC_CLK_HZ = 48000000;
+// Samples per DMA pass before the control channel re-arms it; any multiple of
+// the ring size keeps the write pointer continuous
+static constexpr uint32_t PASS_SAMPLES = 1u << 20;
+
+AnalogInput::AnalogInput() {
+    memset(ring, 0, sizeof(ring));
+    active = false;
+    host_head = 0;
+    chan = ctrl_chan = -1;
+    reload_count = PASS_SAMPLES;
+}
+
+uint16_t AnalogInput::read() const {
+    uint32_t end = write_index();
+    uint32_t sum = 0;
+    for (int i = 1; i <= WINDOW; ++i) sum += ring[(end - i) & (RING_SIZE - 1)];
+    return (uint16_t)(sum >> (WINDOW_BITS - FRAC_BITS));
+}
+
+uint16_t AnalogInput::latest() const {
+    return ring[(write_index() - 1) & (RING_SIZE - 1)];
+}
+
+// Fill the ring with one conversion so read() is valid before the DMA has
+// gone round once
+void AnalogInput::seed(int gpio, int channel) {
+    hal_adc_init(gpio, channel);
+    uint16_t first = hal_adc_read();
+    for (int i = 0; i < RING_SIZE; ++i) ring[i] = first;
+    host_head = 0;
+}
+
+void AnalogInput::feed(uint16_t sample) {
+    ring[host_head & (RING_SIZE - 1)] = sample & 0x0FFF;
+    host_head++;
+}
+
+#ifndef HOST_BUILD
+
+static bool adc_claimed = false;
+
+bool AnalogInput::begin(int gpio, int channel) {
+    if (active || adc_claimed) return false;
+    seed(gpio, channel);
+
+    // FIFO on, DREQ at 1 sample, no error bit, full 12-bit samples
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv((float)(ADC_CLK_HZ / SAMPLE_HZ) - 1.0f);
+
+    chan = dma_claim_unused_channel(true);
+    ctrl_chan = dma_claim_unused_channel(true);
+
+    dma_channel_config c = dma_channel_get_default_config(chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, RING_BITS + 1); // wrap write addr at 512 bytes
+    channel_config_set_dreq(&c, DREQ_ADC);
+    channel_config_set_chain_to(&c, ctrl_chan);
+    dma_channel_configure(chan, &c, ring, &adc_hw->fifo, PASS_SAMPLES, false);
+
+    // rewriting the count retriggers the capture channel where it left off
+    dma_channel_config cc = dma_channel_get_default_config(ctrl_chan);
+    channel_config_set_transfer_data_size(&cc, DMA_SIZE_32);
+    channel_config_set_read_increment(&cc, false);
+    channel_config_set_write_increment(&cc, false);
+    dma_channel_configure(ctrl_chan, &cc, &dma_hw->ch[chan].al1_transfer_count_trig,
+                          &reload_count, 1, false);
+
+    dma_channel_start(chan);
+    adc_run(true);
+    adc_claimed = true;
+    active = true;
+    return true;
+}
+
+void AnalogInput::stop() {
+    if (!active) return;
+    adc_run(false);
+    // with the ADC stopped DREQ stalls the capture channel, so it can't
+    // complete and chain into the control channel while we abort
+    dma_channel_abort(ctrl_chan);
+    dma_channel_abort(chan);
+    dma_channel_unclaim(chan);
+    dma_channel_unclaim(ctrl_chan);
+    adc_fifo_drain();
+    adc_fifo_setup(false, false, 0, false, false);
+    adc_claimed = false;
+    active = false;
+}
+
+uint32_t AnalogInput::write_index() const {
+    if (!active) return 0;
+    uintptr_t addr = dma_hw->ch[chan].write_addr;
+    return (uint32_t)((addr - (uintptr_t)ring) / sizeof(ring[0]));
+}
+
+#else
+
+bool AnalogInput::begin(int gpio, int channel) {
+    seed(gpio, channel);
+    active = true;
+    return true;
+}
+
+void AnalogInput::stop() {
+    active = false;
+}
+
+uint32_t AnalogInput::write_index() const {
+    return host_head;
+}
+
+#endif
@@ -0,0 +1,55 @@
+// analog_input.h - free-running ADC channel streamed into a RAM ring by DMA
+//
+// The ADC converts continuously into its FIFO and a DMA channel copies every
+// sample into a ring buffer (address wrap done by the DMA ring feature); a
+// control channel re-arms it when its count runs out, so sampling never stops
+// and costs no CPU. read() decimates on demand: it averages the newest WINDOW
+// samples, which gives 3 extra bits of resolution and a value at most
+// WINDOW / SAMPLE_HZ old.
+//
+// feed() stands in for the DMA on the host so the filter can be driven with
+// synthetic samples.
+
+#pragma once
+
+#include <cstdint>
+
+class AnalogInput {
+public:
+    static constexpr uint32_t SAMPLE_HZ = 16000;
+    static constexpr int RING_BITS = 8;                // 256 samples, 512 bytes
+    static constexpr int RING_SIZE = 1 << RING_BITS;
+    static constexpr int WINDOW_BITS = 6;              // average of 64 samples
+    static constexpr int WINDOW = 1 << WINDOW_BITS;
+    // read() returns 12-bit ADC counts with this many fraction bits
+    static constexpr int FRAC_BITS = 4;
+
+    AnalogInput();
+
+    // Start continuous sampling of ADC input 'channel' on 'gpio'. Only one
+    // instance can run at a time since the ADC round-robins a single FIFO.
+    bool begin(int gpio, int channel);
+    void stop();
+    bool running() const { return active; }
+
+    // Mean of the newest WINDOW samples, 12.4 fixed point (0..65535)
+    uint16_t read() const;
+    // Newest single sample, 12-bit
+    uint16_t latest() const;
+
+    // Host: append one 12-bit sample as the DMA would
+    void feed(uint16_t sample);
+
+private:
+    alignas(RING_SIZE * 2) uint16_t ring[RING_SIZE];
+    bool active;
+    uint32_t host_head;   // next slot written by feed()
+
+    int chan;
+    int ctrl_chan;
+    uint32_t reload_count; // read by the control channel
+
+    // Index of the slot the DMA will write next
+    uint32_t write_index() const;
+    void seed(int gpio, int channel);
+};
@@ -1,152 +1,350 @@
+// audio.cpp - sound effects on a polyphonic mixer streamed to PWM by DMA
+//
+// Every sfx_* call gets its own mixer voice (stealing the oldest one when all
+// are busy), so effects overlap instead of cutting each other off; a brick
+// hit restarts its own clip if it is still sounding. Two DMA channels
+// ping-pong between sample buffers, paced by the PWM wrap (carrier = sample
+// rate), writing each sample straight into the compare register; the DMA
+// completion IRQ mixes the buffer that just finished.
+//
+// Effects are constexpr NoteTables (tone_table.h) played by reference. A
+// hardware alarm fires at each note boundary and steps every voice's
+// sequence, so timing is exact to the microsecond whatever the main loop is
+// doing.
+
 #include "audio.h"
-#include "pico/stdlib.h"
+#include "audio_mixer.h"
+#include "tone_table.h"
+#include "profiler.h"
+#include <cstring>
+
+#ifndef HOST_BUILD
+#include "hal.h"
 #include "hardware/pwm.h"
 #include "hardware/clocks.h"
-#include "hardware/gpio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
 #include "pico/time.h"
+#else
+#include <cstdio>
+// single-threaded on the host
+static uint32_t save_and_disable_interrupts() { return 0; }
+static void restore_interrupts(uint32_t) {}
+#endif
 
 #define AUDIO_PIN 31
-static uint slice_num;
-static uint chan_num;
+
+// Sequence playing on one mixer voice
+struct Channel {
+    AudioMixer::Wave wave;
+    uint8_t volume;
+    const Note *notes;  // const table, not copied
+    int len;            // 0 = no sequence on this voice
+    int pos;
+    uint64_t next_us;   // end of the current note
+    uint32_t started;   // allocation order, for voice stealing
+};
+
+static const uint64_t NO_EVENT = ~0ull;
+
+static AudioMixer mixer;
+static Channel channels[AudioMixer::MAX_VOICES];
+static uint32_t alloc_count = 0;
+
+static const uint8_t VOL_TONE = 200;
+static const uint8_t VOL_NOISE = 90;
+static const uint8_t VOL_PCM = 255;
+
+// Brick-hit "thunk": a decaying ~180 Hz resonator, generated at compile time
+// so the clip sits in flash
+struct PcmClip { int8_t data[1024]; };
+static constexpr PcmClip make_thunk() {
+    PcmClip c{};
+    const float cos_w = 0.998685f, sin_w = 0.051286f; // w = 2*pi*180/22050
+    const float r = 0.9965f;                           // per-sample decay
+    // y[n] = 127 r^n sin(w n), by the two-pole recurrence
+    float y2 = 0.0f, y1 = 127.0f * r * sin_w;
+    c.data[1] = (int8_t)y1;
+    for (int n = 2; n < 1024; ++n) {
+        float y = 2.0f * r * cos_w * y1 - r * r * y2;
+        y2 = y1;
+        y1 = y;
+        c.data[n] = (int8_t)y;
+    }
+    return c;
+}
+static constexpr PcmClip BRICK_THUNK = make_thunk();
+
+static void audio_init();
+static uint64_t audio_now_us();
+static void audio_schedule(uint64_t next_us);
 static bool audio_active = false;
 
-// Simple non-blocking tone queue
-struct Tone { uint32_t freq; uint32_t ms; };
-static Tone seq_buf[64];
-static int seq_len = 0;
-static int seq_pos = 0;
-static uint32_t seq_remaining_ms = 0;
-static absolute_time_t last_tick;
+static int alloc_voice() {
+    int best = 0;
+    for (int v = 0; v < AudioMixer::MAX_VOICES; ++v) {
+        if (channels[v].len == 0 && !mixer.active(v)) { best = v; break; }
+        if (channels[v].started < channels[best].started) best = v;
+    }
+    channels[best].started = ++alloc_count;
+    return best;
+}
 
-static void audio_init() {
-    gpio_set_function(AUDIO_PIN, GPIO_FUNC_PWM);
-    slice_num = pwm_gpio_to_slice_num(AUDIO_PIN);
-    chan_num  = pwm_gpio_to_channel(AUDIO_PIN);
-    pwm_set_enabled(slice_num, true);
-    audio_active = true;
-    last_tick = get_absolute_time();
+// Step every sequence whose current note has ended by 'now'; returns the next
+// note boundary, or NO_EVENT when nothing is playing
+static uint64_t audio_advance(uint64_t now) {
+    uint64_t next = NO_EVENT;
+    for (int v = 0; v < AudioMixer::MAX_VOICES; ++v) {
+        Channel &ch = channels[v];
+        if (ch.len == 0) continue;
+        if (ch.next_us <= now) {
+            // boundaries accumulate from the sequence start, so no drift
+            while (ch.next_us <= now && ++ch.pos < ch.len) ch.next_us += ch.notes[ch.pos].us;
+            if (ch.pos >= ch.len) {
+                // finished
+                ch.len = 0;
+                mixer.silence(v);
+                continue;
+            }
+            mixer.set_step(v, ch.wave, ch.notes[ch.pos].step, ch.volume);
+        }
+        if (ch.next_us < next) next = ch.next_us;
+    }
+    return next;
 }
 
-static void audio_set_freq_nonblocking(uint32_t freq) {
+// Start a sequence on a free voice; 'notes' must outlive it (flash tables)
+static void audio_play(AudioMixer::Wave wave, uint8_t volume, const Note *notes, int n) {
+    if (n <= 0) return;
     if (!audio_active) audio_init();
-    uint32_t clock_hz = clock_get_hz(clk_sys);
-    if (freq == 0) {
-        // silence: set level 0
-        pwm_set_chan_level(slice_num, chan_num, 0);
-        return;
+    uint32_t irq = save_and_disable_interrupts();
+    int v = alloc_voice();
+    Channel &ch = channels[v];
+    ch.wave = wave;
+    ch.volume = volume;
+    ch.notes = notes;
+    ch.pos = 0;
+    ch.next_us = audio_now_us() + notes[0].us;
+    ch.len = n;
+    mixer.set_step(v, wave, notes[0].step, volume);
+    audio_schedule(audio_advance(audio_now_us()));
+    restore_interrupts(irq);
+}
+
+template <int N>
+static void audio_play(AudioMixer::Wave wave, uint8_t volume, const NoteTable<N> &t) {
+    audio_play(wave, volume, t.notes, N);
+}
+
+// Start a clip; 'voice' remembers where it went, so playing the same effect
+// again while it still sounds restarts it there instead of taking another
+// voice (a burst of brick hits would otherwise steal the music)
+struct PcmVoice {
+    int v;
+    uint32_t started;
+};
+
+static void audio_play_pcm(PcmVoice &voice, const int8_t *data, uint32_t len, uint8_t volume) {
+    if (!audio_active) audio_init();
+    uint32_t irq = save_and_disable_interrupts();
+    int v = voice.v;
+    if (v < 0 || channels[v].started != voice.started || !mixer.active(v)) {
+        v = alloc_voice();
+        voice.v = v;
+        voice.started = channels[v].started;
     }
-    // clamp freq to reasonable range
-    if (freq > (clock_hz / 2)) freq = clock_hz / 2;
-    uint32_t wrap = clock_hz / freq - 1;
-    pwm_set_wrap(slice_num, wrap);
-    pwm_set_chan_level(slice_num, chan_num, wrap / 2);
+    channels[v].len = 0;
+    mixer.play_pcm(v, data, len, AudioMixer::SAMPLE_RATE, volume);
+    restore_interrupts(irq);
 }
 
 void audio_stop() {
-    if (audio_active) {
-        pwm_set_enabled(slice_num, false);
-        gpio_set_function(AUDIO_PIN, GPIO_FUNC_SIO);
-        gpio_put(AUDIO_PIN, 0);
-        audio_active = false;
+    uint32_t irq = save_and_disable_interrupts();
+    for (int v = 0; v < AudioMixer::MAX_VOICES; ++v) channels[v].len = 0;
+    mixer.silence_all();
+    restore_interrupts(irq);
+}
+
+#ifndef HOST_BUILD
+
+static const int BUF_SAMPLES = 256; // ~11.6 ms per buffer
+static uint32_t out_buf[2][BUF_SAMPLES];
+static int dma_chan[2];
+static uint slice_num;
+static uint32_t pwm_wrap;
+static int seq_alarm = -1;
+
+// Mix the next block into buffer b as PWM levels (both CC halves, so the
+// output channel doesn't matter). Silence is level 0, as before.
+static void audio_alarm_cb(uint alarm_num);
+
+static void fill_buffer(int b) {
+    PROFILE_SCOPE(PROF_AUDIO);
+    uint32_t *out = out_buf[b];
+    if (!mixer.any_active()) {
+        memset(out, 0, sizeof(out_buf[b]));
+        return;
+    }
+    int16_t pcm[BUF_SAMPLES];
+    mixer.render(pcm, BUF_SAMPLES);
+    for (int i = 0; i < BUF_SAMPLES; ++i) {
+        uint32_t level = ((uint32_t)(pcm[i] + 32768) * (pwm_wrap + 1)) >> 16;
+        out[i] = level | (level << 16);
     }
-    seq_len = 0; seq_pos = 0; seq_remaining_ms = 0;
 }
 
-// Queue a tone sequence (copy into internal buffer)
-static void audio_queue_sequence(const Tone *seq, int n) {
-    if (n <= 0) return;
-    if (n > (int)(sizeof(seq_buf)/sizeof(seq_buf[0]))) n = sizeof(seq_buf)/sizeof(seq_buf[0]);
-    for (int i = 0; i < n; ++i) seq_buf[i] = seq[i];
-    seq_len = n;
-    seq_pos = 0;
-    seq_remaining_ms = seq_buf[0].ms;
-    if (seq_buf[0].freq == 0) {
-        // silence
-        audio_set_freq_nonblocking(0);
-    } else {
-        audio_set_freq_nonblocking(seq_buf[0].freq);
+static void audio_dma_irq() {
+    for (int b = 0; b < 2; ++b) {
+        uint32_t mask = 1u << dma_chan[b];
+        if (!(dma_hw->ints1 & mask)) continue;
+        dma_hw->ints1 = mask;
+        // the other channel is playing now; re-arm this one (count reloads)
+        dma_channel_set_read_addr(dma_chan[b], out_buf[b], false);
+        fill_buffer(b);
     }
-    last_tick = get_absolute_time();
 }
 
-void audio_update() {
-    if (seq_len == 0) return;
-    absolute_time_t now = get_absolute_time();
-    int32_t delta_ms = (int32_t) to_ms_since_boot(now) - (int32_t) to_ms_since_boot(last_tick);
-    if (delta_ms <= 0) return;
-    last_tick = now;
-    if (seq_remaining_ms > (uint32_t)delta_ms) {
-        seq_remaining_ms -= delta_ms;
-        return;
+static void audio_init() {
+    // carrier = sample rate: each wrap requests the next sample
+    pwm_wrap = clock_get_hz(clk_sys) / AudioMixer::SAMPLE_RATE - 1;
+    slice_num = hal_pwm_init(AUDIO_PIN, pwm_wrap);
+
+    fill_buffer(0);
+    fill_buffer(1);
+    dma_chan[0] = dma_claim_unused_channel(true);
+    dma_chan[1] = dma_claim_unused_channel(true);
+    for (int b = 0; b < 2; ++b) {
+        dma_channel_config c = dma_channel_get_default_config(dma_chan[b]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, pwm_get_dreq(slice_num));
+        channel_config_set_chain_to(&c, dma_chan[b ^ 1]);
+        dma_channel_configure(dma_chan[b], &c, &pwm_hw->slice[slice_num].cc, out_buf[b],
+                              BUF_SAMPLES, false);
+        dma_channel_set_irq1_enabled(dma_chan[b], true);
     }
-    // move to next tone(s)
-    int32_t rem = (int32_t)delta_ms - (int32_t)seq_remaining_ms;
-    seq_pos++;
-    if (seq_pos >= seq_len) {
-        // finished
-        audio_stop();
-        return;
+    irq_add_shared_handler(DMA_IRQ_1, audio_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_start(dma_chan[0]);
+    hal_pwm_set_enabled(AUDIO_PIN, true);
+
+    seq_alarm = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(seq_alarm, audio_alarm_cb);
+    audio_active = true;
+}
+
+static uint64_t audio_now_us() {
+    return time_us_64();
+}
+
+// Arm the alarm for the next note boundary. set_target returns true if the
+// time has already passed; step and retry rather than lose the boundary.
+static void audio_schedule(uint64_t next_us) {
+    while (next_us != NO_EVENT && hardware_alarm_set_target(seq_alarm, from_us_since_boot(next_us))) {
+        next_us = audio_advance(time_us_64());
     }
-    // start next tone
-    if (seq_buf[seq_pos].freq == 0) audio_set_freq_nonblocking(0); else audio_set_freq_nonblocking(seq_buf[seq_pos].freq);
-    // set remaining time for this tone minus leftover delta
-    seq_remaining_ms = seq_buf[seq_pos].ms;
-    if (rem > 0) {
-        if ((uint32_t)rem >= seq_remaining_ms) {
-            // skip ahead (will be handled on next update)
-            seq_remaining_ms = 0;
-        } else {
-            seq_remaining_ms -= rem;
+}
+
+static void audio_alarm_cb(uint alarm_num) {
+    (void)alarm_num;
+    audio_schedule(audio_advance(time_us_64()));
+}
+
+#else
+
+// Host clock: the sample position of audio_render_wav()
+static uint64_t host_samples = 0;
+
+static uint64_t sample_us(uint64_t samples) {
+    return samples * 1000000 / AudioMixer::SAMPLE_RATE;
+}
+
+static void audio_init() {
+    audio_active = true;
+}
+
+static uint64_t audio_now_us() {
+    return sample_us(host_samples);
+}
+
+static void audio_schedule(uint64_t next_us) {
+    (void)next_us;
+}
+
+// Render the next 'ms' of output to a 16-bit mono WAV, stepping the tone
+// sequences at the first sample of each note as the alarm would
+bool audio_render_wav(const char *path, uint32_t ms) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    const uint32_t rate = AudioMixer::SAMPLE_RATE;
+    uint32_t total = (uint32_t)((uint64_t)ms * rate / 1000);
+    uint32_t data_bytes = total * 2;
+    auto put32 = [f](uint32_t v) { uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) }; fwrite(b, 1, 4, f); };
+    auto put16 = [f](uint16_t v) { uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) }; fwrite(b, 1, 2, f); };
+    fwrite("RIFF", 1, 4, f); put32(36 + data_bytes); fwrite("WAVE", 1, 4, f);
+    fwrite("fmt ", 1, 4, f); put32(16); put16(1); put16(1); put32(rate); put32(rate * 2); put16(2); put16(16);
+    fwrite("data", 1, 4, f); put32(data_bytes);
+
+    int16_t buf[256];
+    uint64_t end = host_samples + total;
+    while (host_samples < end) {
+        uint64_t next_us = audio_advance(audio_now_us());
+        uint64_t stop = end;
+        if (next_us != NO_EVENT) {
+            // first sample at or after the boundary
+            uint64_t s = (next_us * rate + 999999) / 1000000;
+            if (s < stop) stop = s;
+        }
+        if (stop <= host_samples) stop = host_samples + 1;
+        while (host_samples < stop) {
+            uint64_t left = stop - host_samples;
+            int n = left < 256 ? (int)left : 256;
+            mixer.render(buf, n);
+            for (int i = 0; i < n; ++i) put16((uint16_t)buf[i]);
+            host_samples += n;
         }
     }
+    fclose(f);
+    return true;
 }
 
+#endif
+
+// Effect tables: built by the compiler, stored in flash
+static constexpr NoteTable<2> WALL_BOUNCE = {{ note(150, 50), note(80, 50) }};
+static constexpr NoteTable<7> START_MELODY = {{
+    note(220, 200), note(262, 200), note(330, 200), note(440, 200),
+    note(392, 200), note(330, 200), note(262, 300)
+}};
+// descending sweep from 200 down to 40 in steps
+static constexpr auto GAME_OVER_SWEEP = sweep<sweep_len(200, 40, 4)>(200, -4, 20);
+// noise crash under the start of the game-over sweep
+static constexpr NoteTable<2> GAME_OVER_CRASH = {{ note(6000, 120), note(2000, 200) }};
+// game_start melody followed by a short descending sweep
+static constexpr auto WIN = concat(START_MELODY, sweep<sweep_len(200, 60, 8)>(200, -8, 30));
+
 void sfx_brick_hit() {
-    Tone t[] = {{70,70},{20,60}};
-    audio_queue_sequence(t, sizeof(t)/sizeof(t[0]));
+    static PcmVoice voice = { -1, 0 };
+    audio_play_pcm(voice, BRICK_THUNK.data, sizeof(BRICK_THUNK.data), VOL_PCM);
 }
 
 void sfx_wall_bounce() {
-    Tone t[] = {{150,50},{80,50}};
-    audio_queue_sequence(t, sizeof(t)/sizeof(t[0]));
+    audio_play(AudioMixer::WAVE_SQUARE, VOL_TONE, WALL_BOUNCE);
 }
 
 void sfx_game_start() {
-    Tone t[] = {{220,200},{262,200},{330,200},{440,200},{392,200},{330,200},{262,300}};
-    audio_queue_sequence(t, sizeof(t)/sizeof(t[0]));
+    audio_play(AudioMixer::WAVE_SQUARE, VOL_TONE, START_MELODY);
 }
 
 void sfx_game_over() {
-    // descending sweep from 200 down to 40 in steps
-    Tone t[48];
-    int n = 0;
-    for (int f = 200; f >= 40 && n < (int)(sizeof(t)/sizeof(t[0])); f -= 4) {
-        t[n++] = { (uint32_t)f, 20 };
-    }
-    audio_queue_sequence(t, n);
+    audio_play(AudioMixer::WAVE_SQUARE, VOL_TONE, GAME_OVER_SWEEP);
+    audio_play(AudioMixer::WAVE_NOISE, VOL_NOISE, GAME_OVER_CRASH);
 }
 
 void sfx_win() {
-    // Combine game_start melody and a short descending sweep
-    Tone start[] = {{220,200},{262,200},{330,200},{440,200},{392,200},{330,200},{262,300}};
-    // descending sweep
-    Tone sweep[32];
-    int sn = 0;
-    for (int f = 200; f >= 60 && sn < (int)(sizeof(sweep)/sizeof(sweep[0])); f -= 8) {
-        sweep[sn++] = { (uint32_t)f, 30 };
-    }
-    // build combined buffer
-    int total = (int)(sizeof(start)/sizeof(start[0])) + sn;
-    if (total > (int)(sizeof(seq_buf)/sizeof(seq_buf[0]))) total = sizeof(seq_buf)/sizeof(seq_buf[0]);
-    int idx = 0;
-    for (int i = 0; i < (int)(sizeof(start)/sizeof(start[0])) && idx < total; ++i) seq_buf[idx++] = start[i];
-    for (int i = 0; i < sn && idx < total; ++i) seq_buf[idx++] = sweep[i];
-    seq_len = idx;
-    seq_pos = 0;
-    if (seq_len > 0) {
-        seq_remaining_ms = seq_buf[0].ms;
-        if (seq_buf[0].freq == 0) audio_set_freq_nonblocking(0); else audio_set_freq_nonblocking(seq_buf[0].freq);
-        last_tick = get_absolute_time();
-    }
+    audio_play(AudioMixer::WAVE_SQUARE, VOL_TONE, WIN);
 }
-
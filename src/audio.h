@@ -8,7 +8,10 @@ void sfx_wall_bounce();
 void sfx_game_start();
 void sfx_game_over();
 void sfx_win();
-// Call frequently from the main loop to advance non-blocking audio playback
-void audio_update();
 // Stop any playing sound immediately
 void audio_stop();
+
+#ifdef HOST_BUILD
+// Render the next 'ms' of mixer output (whatever sfx_* queued) to a WAV file
+bool audio_render_wav(const char *path, uint32_t ms);
+#endif
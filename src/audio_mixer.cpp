@@ -0,0 +1,104 @@
+// audio_mixer.cpp - voice generators and mixdown
+
+#include "audio_mixer.h"
+#include <cstring>
+
+// Per-voice peak before volume (leaves headroom for MAX_VOICES at full volume)
+static constexpr int32_t VOICE_PEAK = 32767 / AudioMixer::MAX_VOICES;
+
+AudioMixer::AudioMixer() {
+    memset(voices, 0, sizeof(voices));
+    silence_all();
+}
+
+void AudioMixer::set_tone(int v, Wave wave, uint32_t freq_hz, uint8_t volume) {
+    set_step(v, wave, phase_inc(freq_hz), volume);
+}
+
+void AudioMixer::set_step(int v, Wave wave, uint32_t step, uint8_t volume) {
+    Voice &vo = voices[v];
+    if (vo.wave != wave) {
+        vo.phase = 0;
+        vo.lfsr = 0xACE1u;
+    }
+    vo.wave = wave;
+    vo.volume = step ? volume : 0;
+    vo.step = step;
+}
+
+void AudioMixer::play_pcm(int v, const int8_t *data, uint32_t len, uint32_t rate_hz, uint8_t volume) {
+    Voice &vo = voices[v];
+    vo.pcm = data;
+    vo.pcm_len = len;
+    vo.phase = 0;
+    vo.step = (uint32_t)(((uint64_t)rate_hz << 16) / SAMPLE_RATE);
+    vo.volume = volume;
+    vo.wave = WAVE_PCM;
+}
+
+void AudioMixer::silence(int v) {
+    voices[v].wave = WAVE_OFF;
+    voices[v].volume = 0;
+}
+
+void AudioMixer::silence_all() {
+    for (int v = 0; v < MAX_VOICES; ++v) silence(v);
+}
+
+bool AudioMixer::any_active() const {
+    for (int v = 0; v < MAX_VOICES; ++v) {
+        if (voices[v].wave != WAVE_OFF) return true;
+    }
+    return false;
+}
+
+void AudioMixer::render(int16_t *out, int n) {
+    int32_t acc[64];
+    while (n > 0) {
+        int chunk = n < 64 ? n : 64;
+        memset(acc, 0, sizeof(acc[0]) * chunk);
+        for (int v = 0; v < MAX_VOICES; ++v) {
+            Voice &vo = voices[v];
+            if (vo.wave == WAVE_OFF) continue;
+            int32_t amp = (VOICE_PEAK * vo.volume) >> 8;
+            switch (vo.wave) {
+            case WAVE_SQUARE:
+                for (int i = 0; i < chunk; ++i) {
+                    acc[i] += (vo.phase & 0x80000000u) ? -amp : amp;
+                    vo.phase += vo.step;
+                }
+                break;
+            case WAVE_NOISE:
+                for (int i = 0; i < chunk; ++i) {
+                    uint32_t prev = vo.phase;
+                    vo.phase += vo.step;
+                    // clock the 16-bit Galois LFSR once per accumulator wrap
+                    if (vo.phase < prev) vo.lfsr = (uint16_t)((vo.lfsr >> 1) ^ (-(vo.lfsr & 1u) & 0xB400u));
+                    acc[i] += (vo.lfsr & 1u) ? amp : -amp;
+                }
+                break;
+            case WAVE_PCM: {
+                int i = 0;
+                for (; i < chunk; ++i) {
+                    uint32_t pos = vo.phase >> 16;
+                    if (pos >= vo.pcm_len) break;
+                    acc[i] += (vo.pcm[pos] * amp) >> 7;
+                    vo.phase += vo.step;
+                }
+                if (i < chunk) silence(v);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        for (int i = 0; i < chunk; ++i) {
+            int32_t s = acc[i];
+            if (s > 32767) s = 32767;
+            if (s < -32768) s = -32768;
+            out[i] = (int16_t)s;
+        }
+        out += chunk;
+        n -= chunk;
+    }
+}
@@ -0,0 +1,54 @@
+// audio_mixer.h - fixed-rate software mixer for the PWM audio output
+//
+// Each voice is a square oscillator, an LFSR noise source or a one-shot PCM
+// clip (signed 8-bit, usually a const table in flash). render() sums the
+// active voices into signed 16-bit samples. There's no hardware dependency:
+// the device streams render() output to PWM by DMA, the host build can write
+// it to a WAV file.
+
+#pragma once
+
+#include <cstdint>
+
+class AudioMixer {
+public:
+    static constexpr uint32_t SAMPLE_RATE = 22050;
+    static constexpr int MAX_VOICES = 4;
+
+    enum Wave : uint8_t { WAVE_OFF, WAVE_SQUARE, WAVE_NOISE, WAVE_PCM };
+
+    // Phase step per sample for a 32-bit accumulator
+    static constexpr uint32_t phase_inc(uint32_t freq_hz) {
+        return (uint32_t)(((uint64_t)freq_hz << 32) / SAMPLE_RATE);
+    }
+
+    AudioMixer();
+
+    // Square wave or noise at freq_hz (noise: rate the LFSR is clocked at).
+    // freq_hz = 0 keeps the voice allocated but silent.
+    void set_tone(int v, Wave wave, uint32_t freq_hz, uint8_t volume);
+    // Same with a precomputed phase_inc() (0 = silent)
+    void set_step(int v, Wave wave, uint32_t step, uint8_t volume);
+    // One-shot clip of len samples recorded at rate_hz; the voice frees itself
+    // at the end
+    void play_pcm(int v, const int8_t *data, uint32_t len, uint32_t rate_hz, uint8_t volume);
+    void silence(int v);
+    void silence_all();
+    bool active(int v) const { return voices[v].wave != WAVE_OFF; }
+    bool any_active() const;
+
+    // Mix n samples (mono)
+    void render(int16_t *out, int n);
+
+private:
+    struct Voice {
+        Wave wave;
+        uint8_t volume;     // 0..255
+        uint32_t phase;     // square/noise: 32-bit accumulator; pcm: 16.16 position
+        uint32_t step;
+        uint16_t lfsr;
+        const int8_t *pcm;
+        uint32_t pcm_len;
+    };
+    Voice voices[MAX_VOICES];
+};
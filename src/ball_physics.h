@@ -0,0 +1,363 @@
+// ball_physics.h - one BrickBreaker physics tick, generic over the scalar type
+//
+// step_ball<float> is the original float physics, step_ball<Fixed> the Q16.16
+// one; both follow the same rules so they can be stepped side by side. The
+// step only moves the ball and kills bricks; score, sound and LCD work is left
+// to the caller through the returned StepResult.
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include "fixed.h"
+
+inline int floor_to_int(float v) { return (int)floorf(v); }
+inline int ceil_to_int(float v) { return (int)ceilf(v); }
+inline int floor_to_int(Fixed v) { return v.raw >> Fixed::FRAC_BITS; }
+inline int ceil_to_int(Fixed v) { return (v.raw + Fixed::ONE - 1) >> Fixed::FRAC_BITS; }
+
+// Live-brick occupancy index: one bit per pixel column for every screen row,
+// the id of the brick covering each pixel, and a count of live bricks. Turns
+// ball-vs-brick tests into a few bit tests and level-clear into a compare.
+// Bricks must not overlap each other.
+struct BrickIndex {
+    static constexpr int MAX_W = 32;
+    static constexpr int MAX_H = 32;
+    static constexpr uint16_t NONE = 0xFFFF;
+
+    uint32_t occ[MAX_H];
+    uint16_t id[MAX_H][MAX_W];
+    int alive;
+
+    template <typename BrickT>
+    void build(const BrickT *bricks, int n, int brick_w, int brick_h) {
+        for (int y = 0; y < MAX_H; ++y) {
+            occ[y] = 0;
+            for (int x = 0; x < MAX_W; ++x) id[y][x] = NONE;
+        }
+        alive = 0;
+        for (int i = 0; i < n; ++i) {
+            if (!bricks[i].alive) continue;
+            alive++;
+            for (int y = bricks[i].y; y < bricks[i].y + brick_h; ++y) {
+                if (y < 0 || y >= MAX_H) continue;
+                for (int x = bricks[i].x; x < bricks[i].x + brick_w; ++x) {
+                    if (x < 0 || x >= MAX_W) continue;
+                    occ[y] |= 1u << x;
+                    id[y][x] = (uint16_t)i;
+                }
+            }
+        }
+    }
+
+    // Drop brick i (at x,y) from the index
+    void remove(int i, int bx, int by, int brick_w, int brick_h) {
+        for (int y = by; y < by + brick_h; ++y) {
+            if (y < 0 || y >= MAX_H) continue;
+            for (int x = bx; x < bx + brick_w; ++x) {
+                if (x < 0 || x >= MAX_W || id[y][x] != i) continue;
+                occ[y] &= ~(1u << x);
+                id[y][x] = NONE;
+            }
+        }
+        alive--;
+    }
+
+    // Call fn(id) for every live-brick pixel in [x0..x1] x [y0..y1]
+    // (a brick shows up once per covered pixel)
+    template <typename F>
+    void for_each_in(int x0, int y0, int x1, int y1, F fn) const {
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (x1 >= MAX_W) x1 = MAX_W - 1;
+        if (y1 >= MAX_H) y1 = MAX_H - 1;
+        if (x0 > x1 || y0 > y1) return;
+        int span = x1 - x0 + 1;
+        uint32_t cols = (span >= 32 ? 0xFFFFFFFFu : ((1u << span) - 1)) << x0;
+        for (int y = y0; y <= y1; ++y) {
+            uint32_t bits = occ[y] & cols;
+            while (bits) {
+                int x = __builtin_ctz(bits);
+                bits &= bits - 1;
+                fn((int)id[y][x]);
+            }
+        }
+    }
+
+    // Lowest brick id covering any pixel in [x0..x1] x [y0..y1], or -1
+    int first_hit(int x0, int y0, int x1, int y1) const {
+        int best = -1;
+        for_each_in(x0, y0, x1, y1, [&best](int b) { if (best < 0 || b < best) best = b; });
+        return best;
+    }
+};
+
+template <typename BrickT>
+inline bool any_alive(const BrickT *bricks, int n) {
+    for (int k = 0; k < n; ++k) { if (bricks[k].alive) return true; }
+    return false;
+}
+
+template <typename S>
+struct BallState {
+    S x, y;
+    S vx, vy;
+};
+
+struct PaddleBox {
+    int x, y, w, h;
+};
+
+struct StepResult {
+    // step_ball_swept stops after this many impacts, so it can't kill more
+    static constexpr int MAX_BRICK_HITS = 8;
+    int wall_bounces;   // walls/ceiling hit this tick
+    bool paddle_hit;
+    int n_brick_hits;   // bricks killed this tick (at most one when not swept)
+    int brick_hits[MAX_BRICK_HITS];
+    bool level_cleared; // the last brick was killed (ball stops there)
+    bool fell;          // ball reached the bottom edge
+};
+
+// Paddle deflection: vx gained per pixel the ball lands off the paddle centre
+static constexpr float PADDLE_DEFLECT = 0.15f;
+
+// With an index the brick test is a bitmap lookup (same brick chosen as the
+// linear scan: the lowest-numbered one the ball overlaps), otherwise every
+// brick is tested in turn.
+template <typename S, typename BrickT>
+StepResult step_ball(BallState<S> &ball, int width, int height, const PaddleBox &paddle,
+                     BrickT *bricks, int n_bricks, int brick_w, int brick_h,
+                     BrickIndex *index = nullptr, S deflect = S(PADDLE_DEFLECT)) {
+    constexpr S MAX_VX = S(2.0f);
+
+    StepResult res = {};
+    S next_x = ball.x + ball.vx;
+    S next_y = ball.y + ball.vy;
+
+    if (next_x < 0) { next_x = 0; ball.vx = -ball.vx; res.wall_bounces++; }
+    if (next_x + 2 > S(width)) { next_x = width - 2; ball.vx = -ball.vx; res.wall_bounces++; }
+    if (next_y < 0) { next_y = 0; ball.vy = -ball.vy; res.wall_bounces++; }
+
+    int ball_left = (int)next_x;
+    int ball_right = (int)next_x + 1;
+    int ball_top = (int)next_y;
+    int ball_bottom = (int)next_y + 1;
+
+    if (ball_bottom >= paddle.y && ball_top <= paddle.y + paddle.h - 1) {
+        if (!(ball_right < paddle.x || ball_left > paddle.x + paddle.w - 1)) {
+            next_y = paddle.y - 2;
+            ball.vy = - (ball.vy < 0 ? -ball.vy : ball.vy);
+            S hit_pos = ((next_x + 1) - S(paddle.x)) - S(paddle.w) / S(2);
+            ball.vx += hit_pos * deflect;
+            if (ball.vx > MAX_VX) ball.vx = MAX_VX;
+            if (ball.vx < -MAX_VX) ball.vx = -MAX_VX;
+            res.paddle_hit = true;
+        }
+    }
+
+    if (index) {
+        // pixels the ball rectangle [next, next+2) overlaps
+        int i = index->first_hit(floor_to_int(next_x), floor_to_int(next_y),
+                                 ceil_to_int(next_x + S(2)) - 1, ceil_to_int(next_y + S(2)) - 1);
+        if (i >= 0) {
+            res.brick_hits[res.n_brick_hits++] = i;
+            bricks[i].hit();
+            index->remove(i, bricks[i].x, bricks[i].y, brick_w, brick_h);
+            ball.vy = -ball.vy;
+            if (index->alive == 0) {
+                res.level_cleared = true;
+                return res;
+            }
+        }
+    } else for (int i = 0; i < n_bricks; ++i) {
+        if (!bricks[i].alive) continue;
+        S bx0 = S(bricks[i].x);
+        S by0 = S(bricks[i].y);
+        S bx1 = bx0 + S(brick_w);
+        S by1 = by0 + S(brick_h);
+
+        S ball_x0 = next_x;
+        S ball_y0 = next_y;
+        S ball_x1 = next_x + S(2);
+        S ball_y1 = next_y + S(2);
+
+        bool overlap = (ball_x0 < bx1) && (ball_x1 > bx0) && (ball_y0 < by1) && (ball_y1 > by0);
+        if (overlap) {
+            res.brick_hits[res.n_brick_hits++] = i;
+            bricks[i].hit();
+            ball.vy = -ball.vy;
+
+            bool any = false;
+            for (int k = 0; k < n_bricks; ++k) { if (bricks[k].alive) { any = true; break; } }
+            if (!any) {
+                // last brick: leave the ball where it was this tick
+                res.level_cleared = true;
+                return res;
+            }
+            // otherwise just stop checking after this collision
+            break;
+        }
+    }
+
+    ball.x = next_x;
+    ball.y = next_y;
+    res.fell = (ball.y + 2 >= S(height));
+    return res;
+}
+
+// ---------------------------------------------------------------------------
+// Swept (continuous) collision: the ball's 2x2 box is moved along its motion
+// segment, the earliest impact (wall, paddle or brick) is resolved with the
+// normal of the face that was hit, and motion continues for the rest of the
+// tick. Nothing can be skipped over regardless of speed.
+
+// Time along an axis at which p + t*v reaches d, clamped to +-BIG so that near
+// zero velocities can't overflow a Fixed
+template <typename S>
+inline S sweep_time(S d, S v) {
+    const S BIG = S(1000);
+    S ad = d < 0 ? -d : d;
+    S av = v < 0 ? -v : v;
+    if (ad >= av * BIG) return ((d < 0) != (v < 0)) ? -BIG : BIG;
+    return d / v;
+}
+
+// Entry/exit times of coordinate p moving at v through the open range (lo, hi)
+template <typename S>
+inline bool sweep_axis(S p, S v, S lo, S hi, S &t_in, S &t_out) {
+    const S BIG = S(1000);
+    if (v == S(0)) {
+        if (!(p > lo && p < hi)) return false;
+        t_in = -BIG;
+        t_out = BIG;
+        return true;
+    }
+    S a = sweep_time(lo - p, v);
+    S b = sweep_time(hi - p, v);
+    if (a < b) { t_in = a; t_out = b; } else { t_in = b; t_out = a; }
+    return true;
+}
+
+enum SweepNormal { NORMAL_X = 1, NORMAL_Y = 2, NORMAL_XY = 3 };
+
+// First contact in [0, t_max) of the moving 2x2 ball with box [x0,x1) x [y0,y1)
+template <typename S>
+inline bool sweep_box(const BallState<S> &b, int x0, int y0, int x1, int y1, S t_max,
+                      S &t_hit, int &normal) {
+    S tx_in, tx_out, ty_in, ty_out;
+    if (!sweep_axis(b.x, b.vx, S(x0 - 2), S(x1), tx_in, tx_out)) return false;
+    if (!sweep_axis(b.y, b.vy, S(y0 - 2), S(y1), ty_in, ty_out)) return false;
+    S t_in = tx_in > ty_in ? tx_in : ty_in;
+    S t_out = tx_out < ty_out ? tx_out : ty_out;
+    if (!(t_in < t_out) || t_out <= S(0) || t_in >= t_max) return false;
+    // the axis entered last is the face that was hit
+    normal = tx_in > ty_in ? NORMAL_X : (ty_in > tx_in ? NORMAL_Y : NORMAL_XY);
+    t_hit = t_in < S(0) ? S(0) : t_in;
+    return true;
+}
+
+template <typename S, typename BrickT>
+StepResult step_ball_swept(BallState<S> &ball, int width, int height, const PaddleBox &paddle,
+                           BrickT *bricks, int n_bricks, int brick_w, int brick_h,
+                           BrickIndex *index = nullptr, S deflect = S(PADDLE_DEFLECT)) {
+    constexpr S MAX_VX = S(2.0f);
+    constexpr int MAX_IMPACTS = StepResult::MAX_BRICK_HITS;
+    enum { HIT_NONE, HIT_LEFT, HIT_RIGHT, HIT_TOP, HIT_PADDLE, HIT_BRICK };
+
+    StepResult res = {};
+    S t_left = S(1);
+    for (int impact = 0; impact < MAX_IMPACTS && t_left > S(0); ++impact) {
+        S t_best = t_left;
+        int what = HIT_NONE;
+        int normal = 0;
+        int brick = -1;
+
+        // walls and ceiling
+        if (ball.vx < 0) {
+            S t = sweep_time(S(0) - ball.x, ball.vx);
+            if (t < t_best) { t_best = t < S(0) ? S(0) : t; what = HIT_LEFT; }
+        } else if (ball.vx > 0) {
+            S t = sweep_time(S(width - 2) - ball.x, ball.vx);
+            if (t < t_best) { t_best = t < S(0) ? S(0) : t; what = HIT_RIGHT; }
+        }
+        if (ball.vy < 0) {
+            S t = sweep_time(S(0) - ball.y, ball.vy);
+            if (t < t_best) { t_best = t < S(0) ? S(0) : t; what = HIT_TOP; }
+        }
+
+        // a paddle that moved onto the ball only bounces it while it still falls
+        S t;
+        int n;
+        if (sweep_box(ball, paddle.x, paddle.y, paddle.x + paddle.w, paddle.y + paddle.h, t_left, t, n) &&
+            t < t_best && (t > S(0) || ball.vy > S(0))) {
+            t_best = t; what = HIT_PADDLE; normal = n;
+        }
+
+        // earliest brick wins; on a tie the lowest-numbered one, as in step_ball
+        auto test_brick = [&](int i) {
+            if (!bricks[i].alive) return;
+            S tb;
+            int nb;
+            if (!sweep_box(ball, bricks[i].x, bricks[i].y, bricks[i].x + brick_w, bricks[i].y + brick_h,
+                           t_left, tb, nb)) return;
+            if (tb < t_best || (what == HIT_BRICK && tb == t_best && i < brick)) {
+                t_best = tb; what = HIT_BRICK; normal = nb; brick = i;
+            }
+        };
+        if (index) {
+            // only bricks under the segment's bounding box can be hit (grown by
+            // a pixel so rounding at the box edges can't drop a candidate)
+            S ex = ball.x + ball.vx * t_best;
+            S ey = ball.y + ball.vy * t_best;
+            int bx0 = floor_to_int(ball.x < ex ? ball.x : ex) - 1;
+            int by0 = floor_to_int(ball.y < ey ? ball.y : ey) - 1;
+            int bx1 = ceil_to_int((ball.x > ex ? ball.x : ex) + S(2));
+            int by1 = ceil_to_int((ball.y > ey ? ball.y : ey) + S(2));
+            index->for_each_in(bx0, by0, bx1, by1, test_brick);
+        } else {
+            for (int i = 0; i < n_bricks; ++i) test_brick(i);
+        }
+
+        // advance to the impact (or to the end of the tick)
+        ball.x += ball.vx * t_best;
+        ball.y += ball.vy * t_best;
+        t_left -= t_best;
+        if (what == HIT_NONE) break;
+
+        switch (what) {
+            case HIT_LEFT:
+                ball.x = 0; ball.vx = -ball.vx; res.wall_bounces++; break;
+            case HIT_RIGHT:
+                ball.x = width - 2; ball.vx = -ball.vx; res.wall_bounces++; break;
+            case HIT_TOP:
+                ball.y = 0; ball.vy = -ball.vy; res.wall_bounces++; break;
+            case HIT_PADDLE:
+                if (normal == NORMAL_X) {
+                    ball.vx = -ball.vx;
+                } else {
+                    ball.vy = - (ball.vy < 0 ? -ball.vy : ball.vy);
+                    S hit_pos = ((ball.x + 1) - S(paddle.x)) - S(paddle.w) / S(2);
+                    ball.vx += hit_pos * deflect;
+                    if (ball.vx > MAX_VX) ball.vx = MAX_VX;
+                    if (ball.vx < -MAX_VX) ball.vx = -MAX_VX;
+                }
+                res.paddle_hit = true;
+                break;
+            case HIT_BRICK:
+                bricks[brick].hit();
+                if (index) index->remove(brick, bricks[brick].x, bricks[brick].y, brick_w, brick_h);
+                res.brick_hits[res.n_brick_hits++] = brick;
+                if (normal & NORMAL_X) ball.vx = -ball.vx;
+                if (normal & NORMAL_Y) ball.vy = -ball.vy;
+                if (index ? index->alive == 0 : !any_alive(bricks, n_bricks)) {
+                    res.level_cleared = true;
+                    return res;
+                }
+                break;
+        }
+    }
+
+    res.fell = (ball.y + 2 >= S(height));
+    return res;
+}
@@ -0,0 +1,45 @@
+// fixed.h - Q16.16 fixed-point scalar used by the ball physics
+//
+// Drop-in for float in the physics code: ints convert implicitly, floats only
+// explicitly (keep those in constexpr so no soft-float code is emitted), and
+// (int) truncates toward zero like a float cast does.
+
+#pragma once
+
+#include <cstdint>
+
+struct Fixed {
+    static constexpr int FRAC_BITS = 16;
+    static constexpr int32_t ONE = 1 << FRAC_BITS;
+
+    int32_t raw;
+
+    constexpr Fixed() : raw(0) {}
+    constexpr Fixed(int v) : raw(v * ONE) {}
+    constexpr explicit Fixed(float f) : raw((int32_t)(f * (float)ONE + (f < 0 ? -0.5f : 0.5f))) {}
+
+    static constexpr Fixed from_raw(int32_t r) { Fixed f; f.raw = r; return f; }
+
+    constexpr explicit operator int() const { return raw / ONE; }
+    constexpr explicit operator float() const { return (float)raw / (float)ONE; }
+
+    constexpr Fixed operator-() const { return from_raw(-raw); }
+    Fixed &operator+=(Fixed o) { raw += o.raw; return *this; }
+    Fixed &operator-=(Fixed o) { raw -= o.raw; return *this; }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) { return from_raw(a.raw + b.raw); }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) { return from_raw(a.raw - b.raw); }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) {
+        return from_raw((int32_t)(((int64_t)a.raw * b.raw) >> FRAC_BITS));
+    }
+    friend constexpr Fixed operator/(Fixed a, Fixed b) {
+        return from_raw((int32_t)(((int64_t)a.raw * ONE) / b.raw));
+    }
+
+    friend constexpr bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend constexpr bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend constexpr bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    friend constexpr bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+    friend constexpr bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+    friend constexpr bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+};
@@ -0,0 +1,48 @@
+// frame_swap.h - lock-free front/back buffer handoff between the game and the refresh core
+//
+// One producer draws into the back buffer and publish()es it; one consumer
+// scans out the front buffer and calls acquire_front() at each frame boundary,
+// which is the only point the two indices change. Only atomic loads/stores are
+// used (no read-modify-write), so it also works on cores without LDREX/STREX.
+// Plain C++ with no Pico dependencies so the protocol runs under std::thread.
+
+#pragma once
+
+#include <atomic>
+
+class FrameSwap {
+public:
+    FrameSwap() : front(0), pending(false) {}
+
+    // Producer side --------------------------------------------------------
+
+    // Buffer the producer may draw into. Only valid while !swap_pending().
+    int back_index() const { return front.load(std::memory_order_acquire) ^ 1; }
+
+    // Hand the back buffer to the consumer; it becomes front at the next frame
+    void publish() { pending.store(true, std::memory_order_release); }
+
+    bool swap_pending() const { return pending.load(std::memory_order_acquire); }
+
+    // Spin until the consumer has taken the published buffer
+    void wait_swapped() const {
+        while (pending.load(std::memory_order_acquire)) { }
+    }
+
+    // Consumer side --------------------------------------------------------
+
+    // Call between frames; returns the buffer to scan out next
+    int acquire_front() {
+        int f = front.load(std::memory_order_relaxed);
+        if (pending.load(std::memory_order_acquire)) {
+            f ^= 1;
+            front.store(f, std::memory_order_relaxed);
+            pending.store(false, std::memory_order_release);
+        }
+        return f;
+    }
+
+private:
+    std::atomic<int> front;
+    std::atomic<bool> pending;
+};
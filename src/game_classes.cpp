@@ -1,87 +1,6 @@
 #include "game_classes.h"
-#include "audio.h"
 #include <cstring>
 
-// Hub75Matrix implementations
-Hub75Matrix::Hub75Matrix() {
-    const uint pins[] = {PIN_R1,PIN_G1,PIN_B1,PIN_R2,PIN_G2,PIN_B2,PIN_A,PIN_B,PIN_C,PIN_D,PIN_CLK,PIN_OE,PIN_LAT};
-    for (auto p : pins) {
-        gpio_init(p);
-        gpio_set_dir(p, GPIO_OUT);
-    }
-
-    // initial states: blank panel
-    gpio_clr_mask(DATA_MASK);
-    gpio_clr_mask(M_CLK | M_LAT);
-    gpio_set_mask(M_OE); // OE=1 -> outputs disabled
-
-    clear();
-}
-
-void Hub75Matrix::set_pixel(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
-    if (x < 0 || x >= 32 || y < 0 || y >= 32) return;
-    fb[y][x][0] = r;
-    fb[y][x][1] = g;
-    fb[y][x][2] = b;
-}
-
-void Hub75Matrix::clear() {
-    memset(fb, 0, sizeof(fb));
-}
-
-void Hub75Matrix::refresh_once() {
-    for (int plane = BITPLANES - 1; plane >= 0; --plane) {
-        int us = (1 << plane) * DWELL_SCALE;
-        for (int row = 0; row < 16; ++row) {
-            gpio_set_mask(M_OE);
-            set_row_address(row);
-            for (int col = 0; col < 32; ++col) {
-                uint8_t r1 = (fb[row][col][0]  >> plane) & 1;
-                uint8_t g1 = (fb[row][col][1]  >> plane) & 1;
-                uint8_t b1 = (fb[row][col][2]  >> plane) & 1;
-                uint8_t r2 = (fb[row+16][col][0] >> plane) & 1;
-                uint8_t g2 = (fb[row+16][col][1] >> plane) & 1;
-                uint8_t b2 = (fb[row+16][col][2] >> plane) & 1;
-
-                uint32_t set_mask = 0;
-                if (r1) set_mask |= M_R1;
-                if (g1) set_mask |= M_G1;
-                if (b1) set_mask |= M_B1;
-                if (r2) set_mask |= M_R2;
-                if (g2) set_mask |= M_G2;
-                if (b2) set_mask |= M_B2;
-
-                gpio_clr_mask(DATA_MASK);
-                if (set_mask) gpio_set_mask(set_mask);
-
-                gpio_set_mask(M_CLK);
-                gpio_clr_mask(M_CLK);
-            }
-
-            gpio_set_mask(M_LAT);
-            busy_wait_us_32(1);
-            gpio_clr_mask(M_LAT);
-
-            gpio_clr_mask(M_OE);
-            busy_wait_us_32(us);
-
-            gpio_set_mask(M_OE);
-        }
-    }
-}
-
-void Hub75Matrix::set_row_address(int row) {
-    uint32_t masks_to_clear = (1u<<PIN_A)|(1u<<PIN_B)|(1u<<PIN_C)|(1u<<PIN_D);
-    uint32_t masks_to_set = 0;
-    if (row & 0x1) masks_to_set |= (1u<<PIN_A);
-    if (row & 0x2) masks_to_set |= (1u<<PIN_B);
-    if (row & 0x4) masks_to_set |= (1u<<PIN_C);
-    if (row & 0x8) masks_to_set |= (1u<<PIN_D);
-
-    gpio_clr_mask(masks_to_clear);
-    if (masks_to_set) gpio_set_mask(masks_to_set);
-}
-
 // Brick implementation
 void Brick::hit() {
     if (!alive) return;
@@ -101,18 +20,22 @@ BrickBreaker::BrickBreaker(Hub75Matrix &matrix) : m(matrix) {
     game_over = false;
     level_cleared = false;
     difficulty = EASY;
-    speed_scale = 1.0f; // default to easy -> will be adjusted by set_difficulty
+    speed_scale = phys_t(1.0f); // default to easy -> will be adjusted by set_difficulty
+    difficulty_speed[EASY] = phys_t(0.5f);
+    difficulty_speed[MEDIUM] = phys_t(1.0f);
+    difficulty_speed[HARD] = phys_t(1.8f);
+    paddle_deflect = phys_t(PADDLE_DEFLECT);
+    layered_render = true;
+    use_brick_index = true;
+    swept_collision = true;
+    layer_state[0].valid = layer_state[1].valid = false;
     init_bricks_for_level();
     reset();
 }
 
 void BrickBreaker::set_difficulty(Difficulty d) {
     difficulty = d;
-    switch (d) {
-        case EASY: speed_scale = 0.5f; break;
-        case MEDIUM: speed_scale = 1.0f; break;
-        case HARD: speed_scale = 1.8f; break;
-    }
+    speed_scale = difficulty_speed[d];
     // apply immediately by resetting ball/paddle to new speed
     reset();
 }
@@ -135,7 +58,9 @@ void BrickBreaker::init_bricks_for_level() {
             bricks[idx].r = 0; bricks[idx].g = 255; bricks[idx].b = 0;
         }
     }
-    lcd_print_score(score, level);
+    brick_index.build(bricks, brick_rows * brick_cols, brick_w, brick_h);
+    rasterize_bricks();
+    emit(EV_SCORE_CHANGED, score, level);
 }
 
 void BrickBreaker::reset() {
@@ -143,8 +68,8 @@ void BrickBreaker::reset() {
     ball_x = paddle_x + (paddle_w - 2) / 2;
     ball_y = paddle_y - 3;
     // base velocities scaled by difficulty (increased to make differences clearer)
-    float base_vx = 1.0f;
-    float base_vy = -1.4f;
+    constexpr phys_t base_vx = phys_t(1.0f);
+    constexpr phys_t base_vy = phys_t(-1.4f);
     ball_vx = base_vx * speed_scale;
     ball_vy = base_vy * speed_scale;
 }
@@ -162,8 +87,7 @@ void BrickBreaker::reset_game() {
 
 void BrickBreaker::mark_level_cleared() {
     level_cleared = true;
-    // Play win sound: combined start melody + sweep
-    sfx_win();
+    emit(EV_LEVEL_CLEARED, 0, level);
 }
 
 void BrickBreaker::advance_level() {
@@ -181,73 +105,41 @@ void BrickBreaker::move_paddle_right() {
 }
 
 void BrickBreaker::update_physics() {
-    float next_x = ball_x + ball_vx;
-    float next_y = ball_y + ball_vy;
-
-    if (next_x < 0) { next_x = 0; ball_vx = -ball_vx; sfx_wall_bounce(); }
-    if (next_x + 2 > WIDTH) { next_x = WIDTH - 2; ball_vx = -ball_vx; sfx_wall_bounce(); }
-    if (next_y < 0) { next_y = 0; ball_vy = -ball_vy; sfx_wall_bounce(); }
-
-    int ball_left = (int)next_x;
-    int ball_right = (int)next_x + 1;
-    int ball_top = (int)next_y;
-    int ball_bottom = (int)next_y + 1;
-
-    if (ball_bottom >= paddle_y && ball_top <= paddle_y + paddle_h - 1) {
-        if (!(ball_right < paddle_x || ball_left > paddle_x + paddle_w - 1)) {
-            next_y = paddle_y - 2;
-            ball_vy = - (ball_vy < 0 ? -ball_vy : ball_vy);
-            float hit_pos = ((next_x + 1) - paddle_x) - (paddle_w / 2.0f);
-            ball_vx += hit_pos * 0.15f;
-            if (ball_vx > 2.0f) ball_vx = 2.0f;
-            if (ball_vx < -2.0f) ball_vx = -2.0f;
-        }
+    BallState<phys_t> ball = { ball_x, ball_y, ball_vx, ball_vy };
+    PaddleBox paddle = { paddle_x, paddle_y, paddle_w, paddle_h };
+    BrickIndex *index = use_brick_index ? &brick_index : nullptr;
+    StepResult res = swept_collision
+        ? step_ball_swept(ball, WIDTH, HEIGHT, paddle, bricks, brick_rows * brick_cols, brick_w, brick_h, index,
+                          paddle_deflect)
+        : step_ball(ball, WIDTH, HEIGHT, paddle, bricks, brick_rows * brick_cols, brick_w, brick_h, index,
+                    paddle_deflect);
+    ball_x = ball.x;
+    ball_y = ball.y;
+    ball_vx = ball.vx;
+    ball_vy = ball.vy;
+
+    for (int i = 0; i < res.wall_bounces; ++i) emit(EV_WALL_BOUNCE);
+
+    for (int i = 0; i < res.n_brick_hits; ++i) {
+        score += level * 50;
+        emit(EV_BRICK_HIT, res.brick_hits[i]);
+        erase_brick(res.brick_hits[i]);
     }
-
-    for (int i = 0; i < brick_rows * brick_cols; ++i) {
-        if (!bricks[i].alive) continue;
-        float bx0 = (float)bricks[i].x;
-        float by0 = (float)bricks[i].y;
-        float bx1 = bx0 + (float)brick_w;
-        float by1 = by0 + (float)brick_h;
-
-        float ball_x0 = next_x;
-        float ball_y0 = next_y;
-        float ball_x1 = next_x + 2.0f;
-        float ball_y1 = next_y + 2.0f;
-
-        bool overlap = (ball_x0 < bx1) && (ball_x1 > bx0) && (ball_y0 < by1) && (ball_y1 > by0);
-        if (overlap) {
-            if (bricks[i].alive) {
-                score += level * 50;
-                lcd_print_score(score, level);
-                sfx_brick_hit();
-            }
-            bricks[i].hit();
-            ball_vy = -ball_vy;
-
-            bool any = false;
-            for (int k = 0; k < brick_rows * brick_cols; ++k) { if (bricks[k].alive) { any = true; break; } }
-            if (!any) {
-                // all bricks cleared: mark level cleared and pause the game
-                mark_level_cleared();
-                return; // avoid overwriting ball position later in this tick
-            }
-            // otherwise just stop checking after this collision
-            break;
-        }
+    if (res.n_brick_hits) emit(EV_SCORE_CHANGED, score, level);
+    if (res.level_cleared) {
+        // all bricks cleared: mark level cleared and pause the game
+        mark_level_cleared();
+        return;
     }
 
-    ball_x = next_x;
-    ball_y = next_y;
-
-    if (ball_y + 2 >= HEIGHT) {
+    if (res.fell) {
            // ball fell off bottom -> lose a life
            lives -= 1;
+           emit(EV_LIFE_LOST, lives);
            if (lives <= 0) {
                // game over: stop updating ball/paddle until reset
                game_over = true;
-               sfx_game_over();
+               emit(EV_GAME_OVER, score);
                return;
            } else {
                // reset ball/paddle but keep current bricks and level
@@ -257,24 +149,135 @@ void BrickBreaker::update_physics() {
     }
 }
 
-void BrickBreaker::render() {
-    m.clear();
+void BrickBreaker::save(GameSnapshot &s) const {
+    static_assert(brick_rows * brick_cols <= 32, "bricks_alive holds one bit per brick");
+    memset((void *)&s, 0, sizeof(s));
+    s.ball_x = ball_x;
+    s.ball_y = ball_y;
+    s.ball_vx = ball_vx;
+    s.ball_vy = ball_vy;
+    s.speed_scale = speed_scale;
+    for (int i = 0; i < brick_rows * brick_cols; ++i) {
+        if (bricks[i].alive) s.bricks_alive |= 1u << i;
+    }
+    s.score = score;
+    s.level = (int16_t)level;
+    s.lives = (int8_t)lives;
+    s.paddle_x = (int8_t)paddle_x;
+    s.difficulty = (uint8_t)difficulty;
+    s.game_over = game_over;
+    s.level_cleared = level_cleared;
+}
+
+void BrickBreaker::restore(const GameSnapshot &s) {
+    ball_x = s.ball_x;
+    ball_y = s.ball_y;
+    ball_vx = s.ball_vx;
+    ball_vy = s.ball_vy;
+    speed_scale = s.speed_scale;
+    for (int i = 0; i < brick_rows * brick_cols; ++i) bricks[i].alive = (s.bricks_alive >> i) & 1u;
+    brick_index.build(bricks, brick_rows * brick_cols, brick_w, brick_h);
+    score = s.score;
+    level = s.level;
+    lives = s.lives;
+    paddle_x = s.paddle_x;
+    difficulty = (Difficulty)s.difficulty;
+    game_over = s.game_over;
+    level_cleared = s.level_cleared;
+    rasterize_bricks();
+    layer_state[0].valid = layer_state[1].valid = false;
+    emit(EV_SCORE_CHANGED, score, level);
+}
+
+void BrickBreaker::rasterize_bricks() {
+    memset(brick_layer, 0, sizeof(brick_layer));
     for (int i = 0; i < brick_rows * brick_cols; ++i) {
         if (!bricks[i].alive) continue;
         for (int yy = 0; yy < brick_h; ++yy) for (int xx = 0; xx < brick_w; ++xx) {
-            m.set_pixel(bricks[i].x + xx, bricks[i].y + yy, bricks[i].r, bricks[i].g, bricks[i].b);
+            int px = bricks[i].x + xx;
+            int py = bricks[i].y + yy;
+            if (px < 0 || px >= WIDTH || py < 0 || py >= HEIGHT) continue;
+            brick_layer[py][px][0] = bricks[i].r;
+            brick_layer[py][px][1] = bricks[i].g;
+            brick_layer[py][px][2] = bricks[i].b;
         }
     }
+    layer_state[0].dirty_rows = layer_state[1].dirty_rows = 0xFFFFFFFFu;
+}
 
-    for (int yy = 0; yy < paddle_h; ++yy) for (int xx = 0; xx < paddle_w; ++xx) {
-        m.set_pixel(paddle_x + xx, paddle_y + yy, 0, 0, 255);
+void BrickBreaker::erase_brick(int i) {
+    uint32_t rows = 0;
+    int x0 = bricks[i].x < 0 ? 0 : bricks[i].x;
+    int x1 = bricks[i].x + brick_w > WIDTH ? WIDTH : bricks[i].x + brick_w;
+    for (int yy = 0; yy < brick_h; ++yy) {
+        int py = bricks[i].y + yy;
+        if (py < 0 || py >= HEIGHT || x1 <= x0) continue;
+        memset(brick_layer[py][x0], 0, (size_t)(x1 - x0) * 3);
+        rows |= 1u << py;
     }
+    layer_state[0].dirty_rows |= rows;
+    layer_state[1].dirty_rows |= rows;
+}
+
+// Copy a rectangle of the brick layer back into the matrix
+void BrickBreaker::restore_rect(int x, int y, int w, int h) {
+    // clip here so the source is indexed at the clipped origin
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > WIDTH) w = WIDTH - x;
+    if (y + h > HEIGHT) h = HEIGHT - y;
+    if (w <= 0 || h <= 0) return;
+    m.blit_unchecked(x, y, w, h, &brick_layer[y][x], WIDTH);
+}
+
+void BrickBreaker::draw_sprites(LayerState &st) {
+    m.fill_rect(paddle_x, paddle_y, paddle_w, paddle_h, 0, 0, 255);
 
     int bx = (int)ball_x;
     int by = (int)ball_y;
-    for (int yy = 0; yy < 2; ++yy) for (int xx = 0; xx < 2; ++xx) {
-        int px = bx + xx;
-        int py = by + yy;
-        if (px >= 0 && px < WIDTH && py >= 0 && py < HEIGHT) m.set_pixel(px, py, 255, 255, 255);
+    m.fill_rect(bx, by, 2, 2, 255, 255, 255);
+
+    st.paddle_x = paddle_x;
+    st.paddle_y = paddle_y;
+    st.ball_x = bx;
+    st.ball_y = by;
+}
+
+void BrickBreaker::render() {
+    if (layered_render) render_layered();
+    else render_full();
+}
+
+void BrickBreaker::render_layered() {
+    LayerState &st = layer_state[m.draw_buffer()];
+    if (!st.valid || st.clears != m.clear_count()) {
+        // someone else drew into this buffer (text overlay, first frame):
+        // lay down the whole background once
+        restore_rect(0, 0, WIDTH, HEIGHT);
+    } else {
+        // undo last frame's sprites and pick up bricks that died since
+        restore_rect(st.paddle_x, st.paddle_y, paddle_w, paddle_h);
+        restore_rect(st.ball_x, st.ball_y, 2, 2);
+        for (int row = 0; row < HEIGHT; ++row) {
+            if (st.dirty_rows & (1u << row)) restore_rect(0, row, WIDTH, 1);
+        }
+    }
+    st.dirty_rows = 0;
+    draw_sprites(st);
+    st.clears = m.clear_count();
+    st.valid = true;
+}
+
+void BrickBreaker::render_full() {
+    m.clear();
+    for (int i = 0; i < brick_rows * brick_cols; ++i) {
+        if (!bricks[i].alive) continue;
+        m.fill_rect(bricks[i].x, bricks[i].y, brick_w, brick_h, bricks[i].r, bricks[i].g, bricks[i].b);
     }
+
+    m.fill_rect(paddle_x, paddle_y, paddle_w, paddle_h, 0, 0, 255);
+
+    int bx = (int)ball_x;
+    int by = (int)ball_y;
+    m.fill_rect(bx, by, 2, 2, 255, 255, 255);
 }
@@ -7,58 +7,25 @@
 #include <cstdlib>
 #include <cstring>
 #include <cstdint>
-#include "pico/stdlib.h"
-#include "hardware/gpio.h"
-
-// LCD score functions (implemented in score.cpp)
-void lcd_init_display();
-void lcd_print_score(int score, int level);
-
-// Hub75Matrix: simple GPIO bit-banged driver for 32x32 HUB75
-class Hub75Matrix {
-public:
-    // Pin definitions (user-provided mapping)
-    static constexpr uint PIN_R1 = 21;
-    static constexpr uint PIN_G1 = 20;
-    static constexpr uint PIN_B1 = 19;
-    static constexpr uint PIN_R2 = 18;
-    static constexpr uint PIN_G2 = 17;
-    static constexpr uint PIN_B2 = 16;
-    static constexpr uint PIN_A  = 26;
-    static constexpr uint PIN_B  = 27;
-    static constexpr uint PIN_C  = 28;
-    static constexpr uint PIN_D  = 29;
-    static constexpr uint PIN_CLK= 15;
-    static constexpr uint PIN_OE = 13;
-    static constexpr uint PIN_LAT= 14;
-
-    // masks
-    static constexpr uint32_t M_R1 = 1u << PIN_R1;
-    static constexpr uint32_t M_G1 = 1u << PIN_G1;
-    static constexpr uint32_t M_B1 = 1u << PIN_B1;
-    static constexpr uint32_t M_R2 = 1u << PIN_R2;
-    static constexpr uint32_t M_G2 = 1u << PIN_G2;
-    static constexpr uint32_t M_B2 = 1u << PIN_B2;
-    static constexpr uint32_t M_CLK= 1u << PIN_CLK;
-    static constexpr uint32_t M_LAT= 1u << PIN_LAT;
-    static constexpr uint32_t M_OE = 1u << PIN_OE;
-    static constexpr uint32_t DATA_MASK = M_R1|M_G1|M_B1|M_R2|M_G2|M_B2;
-
-    // Refresh tuning
-    static constexpr int BITPLANES = 5; // fewer planes -> faster refresh
-    static constexpr int DWELL_SCALE = 4; // smaller dwell -> faster refresh
-
-    // framebuffer
-    uint8_t fb[32][32][3];
-
-    Hub75Matrix();
-    void set_pixel(int x, int y, uint8_t r, uint8_t g, uint8_t b);
-    void clear();
-    void refresh_once();
-
-private:
-    void set_row_address(int row);
-};
+#include "hal.h"
+#include "hub75_panel.h"
+#include "ball_physics.h"
+#include "game_events.h"
+
+// Ball physics scalar: 1 = Q16.16 fixed point (deterministic, no soft-float),
+// 0 = float. Override with -DBRICK_FIXED_POINT=0 in build flags.
+#ifndef BRICK_FIXED_POINT
+#define BRICK_FIXED_POINT 1
+#endif
+
+#if BRICK_FIXED_POINT
+typedef Fixed phys_t;
+#else
+typedef float phys_t;
+#endif
+
+// Hub75Matrix: the game's single 32x32, 1/16 scan panel
+class Hub75Matrix : public Hub75Panel<Hub75Config32x32> {};
 
 // Brick data
 struct Brick {
@@ -69,6 +36,23 @@ struct Brick {
     void hit();
 };
 
+// Everything the game's future depends on, for keyframes in input
+// recordings (input_record.h). Plain data, saved and loaded with memcpy.
+struct GameSnapshot {
+    phys_t ball_x, ball_y;
+    phys_t ball_vx, ball_vy;
+    phys_t speed_scale;
+    uint32_t bricks_alive; // bit i = bricks[i]
+    int32_t score;
+    int16_t level;
+    int8_t lives;
+    int8_t paddle_x;
+    uint8_t difficulty;
+    uint8_t game_over;
+    uint8_t level_cleared;
+    uint8_t pad;
+};
+
 // BrickBreaker class
 class BrickBreaker {
 public:
@@ -85,8 +69,8 @@ public:
     int paddle_y;
 
     // Ball
-    float ball_x, ball_y;
-    float ball_vx, ball_vy;
+    phys_t ball_x, ball_y;
+    phys_t ball_vx, ball_vy;
 
     // Bricks
     static constexpr int brick_w = 4;
@@ -95,6 +79,11 @@ public:
     static constexpr int brick_cols = 6;
     static constexpr int brick_rows = 4;
     Brick bricks[brick_rows * brick_cols];
+    // Occupancy bitmap + live count; set use_brick_index = false for the plain scan
+    BrickIndex brick_index;
+    bool use_brick_index;
+    // Swept collision: no tunnelling through bricks/paddle at high ball speeds
+    bool swept_collision;
 
     // Score / level
     int score;
@@ -103,7 +92,20 @@ public:
     bool game_over;
     bool level_cleared;
     Difficulty difficulty;
-    float speed_scale; // multiplier applied to base ball speed
+    phys_t speed_scale; // multiplier applied to base ball speed
+    // Tuning, not game state: speed_scale per Difficulty and the paddle's
+    // deflection (PADDLE_DEFLECT), for host tools to sweep
+    phys_t difficulty_speed[3];
+    phys_t paddle_deflect;
+
+    // Layered rendering: bricks live in a cached background layer and only the
+    // rectangles the paddle and ball move from/to are recomposited each frame.
+    // Set to false to redraw everything every frame.
+    bool layered_render;
+    uint8_t brick_layer[HEIGHT][WIDTH][3];
+
+    // Sound/LCD side effects; the game only produces, see game_events.h
+    GameEventQueue events;
 
     BrickBreaker(Hub75Matrix &matrix);
     void set_difficulty(Difficulty d);
@@ -118,4 +120,27 @@ public:
     void move_paddle_right();
     void update_physics();
     void render();
+
+    void save(GameSnapshot &s) const;
+    // Bricks, ball, paddle and score from s; both layer buffers get redrawn
+    void restore(const GameSnapshot &s);
+
+private:
+    // What this game last drew into each of the matrix buffers
+    struct LayerState {
+        bool valid;
+        uint32_t clears;     // matrix clear_count() right after drawing
+        uint32_t dirty_rows; // brick layer rows changed since then
+        int paddle_x, paddle_y;
+        int ball_x, ball_y;
+    };
+    LayerState layer_state[2];
+
+    void emit(GameEventType type, int32_t a = 0, int32_t b = 0) { events.push({ type, a, b }); }
+    void rasterize_bricks();
+    void erase_brick(int i);
+    void restore_rect(int x, int y, int w, int h);
+    void draw_sprites(LayerState &st);
+    void render_full();
+    void render_layered();
 };
@@ -0,0 +1,29 @@
+// game_events.h - side effects of the game logic, queued for a consumer
+//
+// BrickBreaker never calls the audio or LCD drivers itself; it pushes one of
+// these per effect and whoever owns the drivers drains the queue (a
+// low-priority task, the other core, or nothing at all on a headless host).
+
+#pragma once
+
+#include <cstdint>
+#include "spsc_queue.h"
+
+enum GameEventType : uint8_t {
+    EV_BRICK_HIT,      // a = brick index
+    EV_WALL_BOUNCE,
+    EV_SCORE_CHANGED,  // a = score, b = level
+    EV_LIFE_LOST,      // a = lives left
+    EV_LEVEL_CLEARED,  // b = level
+    EV_GAME_OVER,      // a = final score
+};
+
+struct GameEvent {
+    GameEventType type;
+    int32_t a;
+    int32_t b;
+};
+
+// Worst tick: MAX_BRICK_HITS + wall bounces + score updates, with room for
+// the consumer to fall a few ticks behind
+typedef SpscQueue<GameEvent, 64> GameEventQueue;
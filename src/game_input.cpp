@@ -0,0 +1,68 @@
+// game_input.cpp - joystick paddle mapping and keypad commands
+
+#include "game_input.h"
+
+// Calibrated ranges below 16 ADC counts are noise; also avoids dividing by 0
+static constexpr uint16_t MIN_CAL_RANGE = 16 << 4;
+
+JoystickPaddle::JoystickPaddle(const JoystickParams &p)
+    : params(p), gain(p.smooth * p.sensitivity), max_step(p.max_step), deadzone(p.deadzone) {
+    state.cal_center = 2048 << 4;
+    state.cal_range = 2048 << 4;
+    state.target = Fixed(0);
+}
+
+void JoystickPaddle::calibrate(uint16_t center, uint16_t range) {
+    state.cal_center = center;
+    state.cal_range = range < MIN_CAL_RANGE ? MIN_CAL_RANGE : range;
+}
+
+int JoystickPaddle::update(uint16_t raw, int max_x) {
+    int32_t delta = (int32_t)raw - (int32_t)state.cal_center;
+    // approx -1..1
+    Fixed norm = Fixed::from_raw((int32_t)((int64_t)delta * Fixed::ONE / state.cal_range));
+    if (params.invert) norm = -norm;
+    if (norm > Fixed(1)) norm = Fixed(1);
+    if (norm < Fixed(-1)) norm = Fixed(-1);
+    // outside the deadzone move toward the deflection; idle keeps the last
+    // target (no drift toward center)
+    if (norm > deadzone || norm < -deadzone) {
+        // convert -1..1 to 0..max_x
+        Fixed desired = (norm + 1) * Fixed(max_x) / 2;
+        Fixed step = (desired - state.target) * gain;
+        if (step > max_step) step = max_step;
+        if (step < -max_step) step = -max_step;
+        state.target += step;
+    }
+    int x = (int)(state.target + Fixed::from_raw(Fixed::ONE / 2));
+    if (x < 0) x = 0;
+    if (x > max_x) x = max_x;
+    return x;
+}
+
+void game_tick(BrickBreaker &game, JoystickPaddle &joy, uint16_t raw) {
+    if (game.is_game_over() || game.is_level_cleared()) return;
+    game.paddle_x = joy.update(raw, BrickBreaker::WIDTH - game.paddle_w);
+    game.update_physics();
+}
+
+KeyResult game_key(BrickBreaker &game, char k) {
+    KeyResult r = { nullptr, 0 };
+    if (!game.is_game_over() && !game.is_level_cleared()) {
+        if (k == 'A') {
+            game.set_difficulty(BrickBreaker::EASY);
+            r = { "EASY", 1000 };
+        } else if (k == 'B') {
+            game.set_difficulty(BrickBreaker::MEDIUM);
+            r = { "MEDIUM", 1000 };
+        } else if (k == 'C') {
+            game.set_difficulty(BrickBreaker::HARD);
+            r = { "HARD", 1000 };
+        }
+    } else if (k == 'B') {
+        if (game.is_game_over()) game.reset_game();
+        else game.advance_level();
+        r = { "READY", 800 };
+    }
+    return r;
+}
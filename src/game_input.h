@@ -0,0 +1,66 @@
+// game_input.h - how the joystick and keypad drive BrickBreaker
+//
+// main() feeds these from the ADC and the keypad scanner; the replay driver
+// and host tools feed recorded or scripted input through the same code, so a
+// given input sequence always plays out the same way.
+
+#pragma once
+
+#include <cstdint>
+#include "fixed.h"
+#include "game_classes.h"
+
+// Joystick-to-paddle tuning
+struct JoystickParams {
+    bool invert;       // positive deflection moves left
+    float sensitivity; // lower -> slower movement, 0.0..1.0
+    float smooth;      // base fraction of the distance to the target moved per tick
+    float max_step;    // most pixels the paddle may move per tick
+    float deadzone;    // fraction of the calibrated range treated as idle
+};
+
+static constexpr JoystickParams JOY_DEFAULT_PARAMS = { true, 0.4f, 0.2f, 3.0f, 0.08f };
+
+// Maps filtered joystick readings (12-bit ADC counts with 4 fraction bits, as
+// AnalogInput::read() returns them) to a smoothed paddle position. The
+// mapping runs in Q16.16 whatever the physics scalar is: its state goes into
+// recordings, and float code can round differently on the device (fused
+// multiply-add) than on the host. params are converted at construction.
+class JoystickPaddle {
+public:
+    // Calibrated from a sweep at boot, then carried by the smoothing
+    struct State {
+        uint16_t cal_center;
+        uint16_t cal_range;
+        Fixed target; // smoothed paddle x
+    };
+
+    JoystickParams params;
+    State state;
+
+    explicit JoystickPaddle(const JoystickParams &p = JOY_DEFAULT_PARAMS);
+    void calibrate(uint16_t center, uint16_t range);
+    void reset(int paddle_x) { state.target = Fixed(paddle_x); }
+
+    // New paddle x (0..max_x) for reading raw
+    int update(uint16_t raw, int max_x);
+
+private:
+    Fixed gain;     // smooth * sensitivity
+    Fixed max_step;
+    Fixed deadzone;
+};
+
+// One physics tick: paddle from the joystick reading, then the ball. Does
+// nothing while the game is over or the level is cleared.
+void game_tick(BrickBreaker &game, JoystickPaddle &joy, uint16_t raw);
+
+// What a keypad press did; banner is null if the key was ignored
+struct KeyResult {
+    const char *banner;
+    uint32_t banner_ms;
+};
+
+// A/B/C pick the difficulty while playing, B restarts after game over or
+// moves on after a cleared level
+KeyResult game_key(BrickBreaker &game, char k);
@@ -0,0 +1,97 @@
+// hal.h - board services the game core uses: GPIO, time, ADC, PWM and the LCD
+//
+// On the Pico the GPIO/time/ADC/PWM calls are inline forwards to the SDK and
+// the LCD is score.cpp. With HOST_BUILD they all come from hal_host.cpp on
+// Linux: GPIO writes land in a simulated output latch, time is the monotonic
+// clock, the ADC returns whatever hal_host_set_adc() last set, and PWM levels
+// and LCD lines are kept for inspection. The streaming paths (PIO refresh,
+// ADC DMA ring, PWM audio DMA) keep their own host stand-ins in their drivers.
+
+#pragma once
+
+#include <cstdint>
+
+#ifndef HOST_BUILD
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/adc.h"
+#include "hardware/pwm.h"
+
+inline void hal_gpio_init_out(uint pin, bool value) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_OUT);
+    gpio_put(pin, value);
+}
+inline void hal_gpio_put(uint pin, bool value) { gpio_put(pin, value); }
+inline void hal_gpio_set_mask(uint32_t mask) { gpio_set_mask(mask); }
+inline void hal_gpio_clr_mask(uint32_t mask) { gpio_clr_mask(mask); }
+inline void hal_gpio_put_masked(uint32_t mask, uint32_t value) { gpio_put_masked(mask, value); }
+
+inline uint32_t hal_time_us() { return time_us_32(); }
+inline uint64_t hal_time_us_64() { return time_us_64(); }
+inline void hal_busy_wait_us(uint32_t us) { busy_wait_us_32(us); }
+// Body of a polling loop with nothing to do
+inline void hal_idle() { tight_loop_contents(); }
+
+// Single conversions on ADC input 'channel' (pin 'gpio')
+inline void hal_adc_init(uint gpio, uint channel) {
+    adc_init();
+    adc_gpio_init(gpio);
+    adc_select_input(channel);
+}
+inline uint16_t hal_adc_read() { return adc_read(); }
+
+// PWM on 'pin' counting 0..wrap, left disabled; returns the slice
+inline uint hal_pwm_init(uint pin, uint32_t wrap) {
+    gpio_set_function(pin, GPIO_FUNC_PWM);
+    uint slice = pwm_gpio_to_slice_num(pin);
+    pwm_config cfg = pwm_get_default_config();
+    pwm_config_set_wrap(&cfg, (uint16_t)wrap);
+    pwm_init(slice, &cfg, false);
+    return slice;
+}
+inline void hal_pwm_set_enabled(uint pin, bool on) { pwm_set_enabled(pwm_gpio_to_slice_num(pin), on); }
+inline void hal_pwm_set_level(uint pin, uint16_t level) { pwm_set_gpio_level(pin, level); }
+
+#else
+
+typedef unsigned int uint;
+
+void hal_gpio_init_out(uint pin, bool value);
+void hal_gpio_put(uint pin, bool value);
+void hal_gpio_set_mask(uint32_t mask);
+void hal_gpio_clr_mask(uint32_t mask);
+void hal_gpio_put_masked(uint32_t mask, uint32_t value);
+
+uint32_t hal_time_us();
+uint64_t hal_time_us_64();
+void hal_busy_wait_us(uint32_t us);
+void hal_idle();
+
+void hal_adc_init(uint gpio, uint channel);
+uint16_t hal_adc_read();
+
+uint hal_pwm_init(uint pin, uint32_t wrap);
+void hal_pwm_set_enabled(uint pin, bool on);
+void hal_pwm_set_level(uint pin, uint16_t level);
+
+// Host side of the simulated hardware
+uint64_t hal_host_gpio_out();              // output latch, bit n = GPIO n
+void hal_host_set_adc(uint16_t value);     // 12-bit, default mid-scale
+uint16_t hal_host_pwm_level(uint pin);
+const char *hal_host_lcd_line(int line);   // 16 characters, not terminated
+// Advance the clock instead of spinning in hal_busy_wait_us(), so refresh
+// code runs at host speed while its timestamps still include the dwell
+void hal_host_skip_waits(bool on);
+
+#endif
+
+// LCD score display (score.cpp on the device)
+void lcd_init_display();
+// Queues the update; never blocks. Only the latest score is sent.
+void lcd_print_score(int score, int level);
+// Second line: lives, difficulty name and a frames-per-second figure
+void lcd_print_status(int lives, const char *difficulty, int fps);
+// Call frequently from the main loop to push queued LCD traffic
+void lcd_update();
@@ -0,0 +1,147 @@
+// hal_host.cpp - Linux implementation of hal.h for HOST_BUILD
+
+#ifdef HOST_BUILD
+
+#include "hal.h"
+#include "lcd_text.h"
+#include <cstring>
+#include <ctime>
+
+static uint64_t gpio_out = 0;
+static uint16_t adc_value = 2048;
+
+static constexpr int PWM_PINS = 48;
+static uint16_t pwm_level[PWM_PINS];
+
+static bool skip_waits = false;
+static uint64_t skipped_us = 0;
+
+static const int LCD_COLS = 16;
+static char lcd_lines[2][LCD_COLS];
+
+static uint64_t monotonic_us() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+// Microseconds since the first call, like time since boot
+static uint64_t boot_us() {
+    static const uint64_t boot = monotonic_us();
+    return boot;
+}
+
+void hal_gpio_init_out(uint pin, bool value) {
+    hal_gpio_put(pin, value);
+}
+
+void hal_gpio_put(uint pin, bool value) {
+    if (value) gpio_out |= 1ull << pin;
+    else gpio_out &= ~(1ull << pin);
+}
+
+void hal_gpio_set_mask(uint32_t mask) {
+    gpio_out |= mask;
+}
+
+void hal_gpio_clr_mask(uint32_t mask) {
+    gpio_out &= ~(uint64_t)mask;
+}
+
+void hal_gpio_put_masked(uint32_t mask, uint32_t value) {
+    gpio_out = (gpio_out & ~(uint64_t)mask) | (value & mask);
+}
+
+uint32_t hal_time_us() {
+    return (uint32_t)hal_time_us_64();
+}
+
+uint64_t hal_time_us_64() {
+    uint64_t boot = boot_us();
+    return monotonic_us() - boot + skipped_us;
+}
+
+void hal_busy_wait_us(uint32_t us) {
+    if (skip_waits) {
+        skipped_us += us;
+        return;
+    }
+    uint64_t end = hal_time_us_64() + us;
+    while (hal_time_us_64() < end) {
+    }
+}
+
+void hal_idle() {}
+
+void hal_adc_init(uint gpio, uint channel) {
+    (void)gpio;
+    (void)channel;
+}
+
+uint16_t hal_adc_read() {
+    return adc_value;
+}
+
+uint hal_pwm_init(uint pin, uint32_t wrap) {
+    (void)wrap;
+    if (pin < PWM_PINS) pwm_level[pin] = 0;
+    return pin / 2 % 12;
+}
+
+void hal_pwm_set_enabled(uint pin, bool on) {
+    (void)pin;
+    (void)on;
+}
+
+void hal_pwm_set_level(uint pin, uint16_t level) {
+    if (pin < PWM_PINS) pwm_level[pin] = level;
+}
+
+uint64_t hal_host_gpio_out() {
+    return gpio_out;
+}
+
+void hal_host_set_adc(uint16_t value) {
+    adc_value = value & 0x0FFF;
+}
+
+uint16_t hal_host_pwm_level(uint pin) {
+    return pin < PWM_PINS ? pwm_level[pin] : 0;
+}
+
+void hal_host_skip_waits(bool on) {
+    skip_waits = on;
+}
+
+// LCD: the two lines as text
+
+static void lcd_set_line(int line, const char *text) {
+    size_t slen = strlen(text);
+    if (slen > (size_t)LCD_COLS) slen = LCD_COLS;
+    memcpy(lcd_lines[line], text, slen);
+    memset(lcd_lines[line] + slen, ' ', LCD_COLS - slen);
+}
+
+const char *hal_host_lcd_line(int line) {
+    return lcd_lines[line & 1];
+}
+
+void lcd_init_display() {
+    memset(lcd_lines, ' ', sizeof(lcd_lines));
+}
+
+void lcd_print_score(int score, int level) {
+    char buf[32];
+    lcd_format_score(buf, sizeof(buf), score, level);
+    lcd_set_line(0, buf);
+}
+
+void lcd_print_status(int lives, const char *difficulty, int fps) {
+    char buf[32];
+    lcd_format_status(buf, sizeof(buf), lives, difficulty, fps);
+    lcd_set_line(1, buf);
+}
+
+void lcd_update() {}
+
+#endif
@@ -0,0 +1,44 @@
+// hub75_config.h - compile-time geometry and pin map for the HUB75 driver
+//
+// A configuration is a type: Hub75Panel and Hub75PioEngine are templates over
+// it, so every loop bound, buffer size and pin mask is a constant in each
+// instantiation and the 32x32 panel compiles to the same code it always did.
+
+#pragma once
+
+#include <cstdint>
+
+// GPIO assignment. The PIO backend needs B2,G2,R2,B1,G1,R1 on consecutive
+// GPIOs, the address pins consecutive from A, and LAT right above OE.
+struct Hub75DefaultPins {
+    static constexpr unsigned R1 = 21;
+    static constexpr unsigned G1 = 20;
+    static constexpr unsigned B1 = 19;
+    static constexpr unsigned R2 = 18;
+    static constexpr unsigned G2 = 17;
+    static constexpr unsigned B2 = 16;
+    static constexpr unsigned ADDR[5] = {26, 27, 28, 29, 30}; // A..E; E only on 1/32 scan
+    static constexpr unsigned CLK = 15;
+    static constexpr unsigned OE  = 13;
+    static constexpr unsigned LAT = 14;
+};
+
+// PANEL_W x PANEL_H modules, SCAN rows per half (1/SCAN scan: rows y and
+// y + SCAN are driven together), CHAIN modules daisy-chained left to right.
+template <int PANEL_W, int PANEL_H, int SCAN, int CHAIN = 1, class PinMap = Hub75DefaultPins>
+struct Hub75Config {
+    typedef PinMap Pins;
+    static constexpr int WIDTH = PANEL_W * CHAIN; // columns shifted per row
+    static constexpr int HEIGHT = PANEL_H;
+    static constexpr int SCAN_ROWS = SCAN;
+    static constexpr int ADDR_PINS = SCAN == 8 ? 3 : SCAN == 16 ? 4 : 5;
+
+    static_assert(SCAN == 8 || SCAN == 16 || SCAN == 32, "scan must be 1/8, 1/16 or 1/32");
+    static_assert(PANEL_H == 2 * SCAN, "only panels whose two halves share an address (H = 2 * scan)");
+    static_assert(WIDTH % 4 == 0 && WIDTH <= 256, "row width must be a multiple of 4 columns");
+};
+
+typedef Hub75Config<32, 32, 16> Hub75Config32x32;
+typedef Hub75Config<64, 32, 16> Hub75Config64x32;
+typedef Hub75Config<64, 64, 32> Hub75Config64x64;
+typedef Hub75Config<64, 32, 16, 2> Hub75Config64x32x2; // 128x32 from two chained modules
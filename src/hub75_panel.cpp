@@ -0,0 +1,614 @@
+// hub75_panel.cpp - Hub75Panel framebuffer, drawing and refresh paths
+
+#include "hub75_panel.h"
+#include <cstring>
+#ifndef HOST_BUILD
+#include "pico/multicore.h"
+#include "hardware/timer.h"
+
+// Panel refreshed in the background (core 1 entry and alarm callbacks take no context).
+// Only one panel can own them, whatever its geometry.
+static void *refresh_owner = nullptr;
+#endif
+
+// GPIO set-mask for each row address, replacing the per-bit branches
+template <class Cfg>
+struct RowAddrTable {
+    uint32_t mask[Cfg::SCAN_ROWS];
+    constexpr RowAddrTable() : mask() {
+        for (int row = 0; row < Cfg::SCAN_ROWS; ++row) {
+            for (int bit = 0; bit < Cfg::ADDR_PINS; ++bit) {
+                if (row & (1 << bit)) mask[row] |= 1u << Cfg::Pins::ADDR[bit];
+            }
+        }
+    }
+};
+template <class Cfg>
+static constexpr RowAddrTable<Cfg> ROW_ADDR{};
+
+template <class Cfg>
+Hub75Panel<Cfg>::Hub75Panel()
+    : governor(SCAN_ROWS, MIN_BITPLANES, MAX_BITPLANES, RefreshGovernor::Setting{BITPLANES, DWELL_SCALE}) {
+    fb = buffers[0];
+    draw_idx = 0;
+    mode = REFRESH_INLINE;
+    planes = BITPLANES;
+    dwell = DWELL_SCALE;
+    buf_planes[0] = buf_planes[1] = BITPLANES;
+    buf_dwell[0] = buf_dwell[1] = DWELL_SCALE;
+    governed_frames = 0;
+    bcm_alarm = -1;
+    bcm_front = 0;
+    bcm_planes = BITPLANES;
+    bcm_dwell = DWELL_SCALE;
+    bcm_plane = BITPLANES - 1;
+    bcm_row = 0;
+    reset_refresh_stats();
+
+    const uint pins[] = {PIN_R1,PIN_G1,PIN_B1,PIN_R2,PIN_G2,PIN_B2,PIN_CLK,PIN_OE,PIN_LAT};
+    for (auto p : pins) hal_gpio_init_out(p, false);
+    for (int i = 0; i < ADDR_PINS; ++i) hal_gpio_init_out(Pins::ADDR[i], false);
+
+    // initial states: blank panel
+    hal_gpio_clr_mask(DATA_MASK);
+    hal_gpio_clr_mask(M_CLK | M_LAT);
+    hal_gpio_set_mask(M_OE); // OE=1 -> outputs disabled
+
+    memset(buffers, 0, sizeof(buffers));
+    memset(packed, 0, sizeof(packed));
+    dirty[0] = dirty[1] = 0;
+    touched[0] = touched[1] = 0;
+    clears[0] = clears[1] = 0;
+#if HUB75_PALETTE_FB
+    for (int i = 0; i < PALETTE_SIZE; ++i) set_palette(i, 0, 0, 0);
+    palette_used = 1; // only black is in use
+#endif
+}
+
+#if HUB75_PALETTE_FB
+template <class Cfg>
+uint8_t Hub75Panel<Cfg>::palette_index(uint8_t r, uint8_t g, uint8_t b) {
+    int best = 0;
+    int best_d = 0x7FFFFFFF;
+    for (int i = 0; i < PALETTE_SIZE; ++i) {
+        if (!(palette_used & (1u << i))) continue;
+        int dr = palette[i][0] - r, dg = palette[i][1] - g, db = palette[i][2] - b;
+        int d = dr * dr + dg * dg + db * db;
+        if (d == 0) return (uint8_t)i;
+        if (d < best_d) { best_d = d; best = i; }
+    }
+    if (palette_used != 0xFFFF) {
+        int i = __builtin_ctz(~palette_used);
+        set_palette(i, r, g, b);
+        return (uint8_t)i;
+    }
+    return (uint8_t)best;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::set_palette(int i, uint8_t r, uint8_t g, uint8_t b) {
+    if (i < 0 || i >= PALETTE_SIZE) return;
+    palette[i][0] = r;
+    palette[i][1] = g;
+    palette[i][2] = b;
+    palette_used |= (uint16_t)(1u << i);
+    for (int bit = 0; bit < MAX_BITPLANES; ++bit) {
+        uint32_t rb = (r >> bit) & 1, gb = (g >> bit) & 1, bb = (b >> bit) & 1;
+        pal_top[bit][i] = (rb << PIN_R1) | (gb << PIN_G1) | (bb << PIN_B1);
+        pal_bot[bit][i] = (rb << PIN_R2) | (gb << PIN_G2) | (bb << PIN_B2);
+    }
+    // pixels using the entry may sit in any row of either buffer
+    dirty[0] = dirty[1] = ALL_SCAN;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::put_index(int x, int y, uint8_t idx) {
+    uint8_t &p = fb[y][x >> 1];
+    p = (x & 1) ? (uint8_t)((p & 0x0F) | (idx << 4)) : (uint8_t)((p & 0xF0) | idx);
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::fill_index(int x, int y, int w, uint8_t idx) {
+    if (x & 1) { put_index(x, y, idx); ++x; --w; }
+    if (w >= 2) memset(&fb[y][x >> 1], idx | (idx << 4), w >> 1);
+    if (w & 1) put_index(x + w - 1, y, idx);
+}
+#endif
+
+template <class Cfg>
+void Hub75Panel<Cfg>::pack_pio(scan_bits_t row_mask) {
+#if HUB75_PALETTE_FB
+    pio_engine.pack(fb, palette, row_mask);
+#else
+    pio_engine.pack(fb, row_mask);
+#endif
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::set_pixel(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return;
+#if HUB75_PALETTE_FB
+    put_index(x, y, palette_index(r, g, b));
+#else
+    fb[y][x][0] = r;
+    fb[y][x][1] = g;
+    fb[y][x][2] = b;
+#endif
+    dirty[draw_idx] |= (scan_bits_t)(1u << (y & (SCAN_ROWS - 1)));
+    touched[draw_idx] |= (row_bits_t)1 << y;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::set_row_mask(int y, uint32_t mask, uint8_t r, uint8_t g, uint8_t b, int x0) {
+    if (y < 0 || y >= HEIGHT) return;
+    // drop the columns off either edge
+    if (x0 < 0) {
+        mask = x0 > -32 ? mask >> -x0 : 0;
+        x0 = 0;
+    }
+    if (WIDTH - x0 < 32) mask &= WIDTH - x0 > 0 ? (1u << (WIDTH - x0)) - 1 : 0;
+    if (!mask) return;
+#if HUB75_PALETTE_FB
+    uint8_t idx = palette_index(r, g, b);
+    for (uint32_t m = mask; m; m &= m - 1) put_index(x0 + __builtin_ctz(m), y, idx);
+#else
+    uint8_t (*row)[3] = &fb[y][x0];
+    for (uint32_t m = mask; m; m &= m - 1) {
+        int x = __builtin_ctz(m);
+        row[x][0] = r;
+        row[x][1] = g;
+        row[x][2] = b;
+    }
+#endif
+    dirty[draw_idx] |= (scan_bits_t)(1u << (y & (SCAN_ROWS - 1)));
+    touched[draw_idx] |= (row_bits_t)1 << y;
+}
+
+// Word stores into the byte framebuffer
+typedef uint32_t __attribute__((may_alias)) fb_word;
+
+template <class Cfg>
+void Hub75Panel<Cfg>::mark_rows(int y, int h) {
+    row_bits_t rows = (h >= HEIGHT) ? ALL_ROWS : (((row_bits_t)1 << h) - 1) << y;
+    touched[draw_idx] |= rows;
+    dirty[draw_idx] |= (scan_bits_t)(rows | (rows >> SCAN_ROWS));
+}
+
+// Clip a rectangle to the panel; sx/sy (source offsets) move with the origin.
+// Returns false if nothing is left.
+template <class Cfg>
+bool Hub75Panel<Cfg>::clip(int &x, int &y, int &w, int &h, int *sx, int *sy) {
+    if (x < 0) { w += x; if (sx) *sx -= x; x = 0; }
+    if (y < 0) { h += y; if (sy) *sy -= y; y = 0; }
+    if (x + w > WIDTH) w = WIDTH - x;
+    if (y + h > HEIGHT) h = HEIGHT - y;
+    return w > 0 && h > 0;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::hline_unchecked(int x, int y, int w, uint8_t r, uint8_t g, uint8_t b) {
+#if HUB75_PALETTE_FB
+    fill_index(x, y, w, palette_index(r, g, b));
+#else
+    uint8_t *p = fb[y][x];
+    // single pixels up to a 4-pixel (12-byte, word aligned) boundary
+    for (; w > 0 && (x & 3); --w, ++x, p += 3) { p[0] = r; p[1] = g; p[2] = b; }
+    if (w >= 4) {
+        // 4 pixels = r g b r | g b r g | b r g b
+        uint32_t w0 = r | (g << 8) | (b << 16) | ((uint32_t)r << 24);
+        uint32_t w1 = g | (b << 8) | (r << 16) | ((uint32_t)g << 24);
+        uint32_t w2 = b | (r << 8) | (g << 16) | ((uint32_t)b << 24);
+        fb_word *q = (fb_word *)p;
+        for (; w >= 4; w -= 4, q += 3) { q[0] = w0; q[1] = w1; q[2] = w2; }
+        p = (uint8_t *)q;
+    }
+    for (; w > 0; --w, p += 3) { p[0] = r; p[1] = g; p[2] = b; }
+#endif
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::hline(int x, int y, int w, uint8_t r, uint8_t g, uint8_t b) {
+    int h = 1;
+    if (!clip(x, y, w, h)) return;
+    hline_unchecked(x, y, w, r, g, b);
+    mark_rows(y, 1);
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::fill_rect_unchecked(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b) {
+#if HUB75_PALETTE_FB
+    uint8_t idx = palette_index(r, g, b);
+    for (int yy = y; yy < y + h; ++yy) fill_index(x, yy, w, idx);
+#else
+    for (int yy = y; yy < y + h; ++yy) hline_unchecked(x, yy, w, r, g, b);
+#endif
+    mark_rows(y, h);
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::fill_rect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b) {
+    if (!clip(x, y, w, h)) return;
+    fill_rect_unchecked(x, y, w, h, r, g, b);
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::blit_unchecked(int x, int y, int w, int h, const uint8_t (*src)[3], int src_stride, bool keyed) {
+#if HUB75_PALETTE_FB
+    // sources are mostly runs of one color; look each new color up once
+    int last = -1;
+    uint8_t idx = 0;
+    for (int yy = 0; yy < h; ++yy, src += src_stride) {
+        for (int xx = 0; xx < w; ++xx) {
+            const uint8_t *s = src[xx];
+            if (keyed && !(s[0] | s[1] | s[2])) continue;
+            int c = (s[0] << 16) | (s[1] << 8) | s[2];
+            if (c != last) { idx = palette_index(s[0], s[1], s[2]); last = c; }
+            put_index(x + xx, y + yy, idx);
+        }
+    }
+#else
+    for (int yy = 0; yy < h; ++yy, src += src_stride) {
+        uint8_t (*dst)[3] = &fb[y + yy][x];
+        if (!keyed) {
+            memcpy(dst, src, (size_t)w * 3);
+            continue;
+        }
+        for (int xx = 0; xx < w; ++xx) {
+            const uint8_t *s = src[xx];
+            if (s[0] | s[1] | s[2]) { dst[xx][0] = s[0]; dst[xx][1] = s[1]; dst[xx][2] = s[2]; }
+        }
+    }
+#endif
+    mark_rows(y, h);
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::blit(int x, int y, int w, int h, const uint8_t (*src)[3], int src_stride, bool keyed) {
+    int sx = 0, sy = 0;
+    if (!clip(x, y, w, h, &sx, &sy)) return;
+    blit_unchecked(x, y, w, h, src + sy * src_stride + sx, src_stride, keyed);
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::clear() {
+    // only rows drawn since the last clear can be non-black
+    row_bits_t t = touched[draw_idx];
+    if (t == ALL_ROWS) {
+        memset(fb, 0, sizeof(buffers[0]));
+    } else {
+        for (int y = 0; y < HEIGHT; ++y) {
+            if (t & ((row_bits_t)1 << y)) memset(fb[y], 0, sizeof(fb[y]));
+        }
+    }
+    dirty[draw_idx] |= (scan_bits_t)(t | (t >> SCAN_ROWS));
+    touched[draw_idx] = 0;
+    clears[draw_idx]++;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::refresh_once() {
+    govern();
+    if (mode == REFRESH_PIO) {
+        // PIO/DMA keeps the panel lit; just publish the rows that changed
+        pack_pio(dirty[draw_idx]);
+        dirty[draw_idx] = 0;
+        return;
+    }
+    repack(draw_idx);
+    if (mode == REFRESH_CORE1 || mode == REFRESH_TIMER) {
+        // core 1 / the alarm IRQ keeps the panel lit; hand over the frame and
+        // draw into the buffer it releases (waits at most one refresh)
+        swap.publish();
+        swap.wait_swapped();
+        draw_idx = swap.back_index();
+        fb = buffers[draw_idx];
+        return;
+    }
+    scan_out(packed[draw_idx], buf_planes[draw_idx], buf_dwell[draw_idx]);
+    note_frame();
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::set_min_refresh_hz(uint32_t hz) {
+    governor.set_target_hz(hz);
+    governed_frames = stats.frames;
+}
+
+template <class Cfg>
+Hub75PanelBase::RefreshTiming Hub75Panel<Cfg>::refresh_timing() const {
+    RefreshTiming t = { planes, dwell, governor.target_hz(), governor.measured_hz() };
+    return t;
+}
+
+// Feed the governor the frames refreshed since the last call and apply its
+// decision. The PIO engine's period is fixed by its timing, so that is used
+// as the measurement there.
+template <class Cfg>
+void Hub75Panel<Cfg>::govern() {
+    if (!governor.target_hz()) return;
+    // the engine's last timing switch hasn't reached a frame boundary yet
+    if (mode == REFRESH_PIO && pio_engine.retime_pending()) return;
+    bool changed;
+    if (mode == REFRESH_PIO) {
+        changed = governor.sample(pio_engine.frame_us());
+    } else {
+        uint32_t frames = stats.frames;
+        if (frames == governed_frames || stats.last_us == 0) return;
+        governed_frames = frames;
+        changed = governor.sample(stats.last_us);
+    }
+    if (changed) apply_timing(governor.setting());
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::apply_timing(RefreshGovernor::Setting s) {
+    planes = s.planes;
+    dwell = s.dwell_us;
+    // every row of both buffers has to be repacked for the new plane set
+    dirty[0] = dirty[1] = ALL_SCAN;
+    if (mode == REFRESH_PIO) {
+        // packed into the engine's spare bank, shown from the next frame
+        // boundary on; the panel stays lit throughout
+        pio_engine.retime(planes, dwell);
+        pack_pio(ALL_SCAN);
+        dirty[draw_idx] = 0;
+        pio_engine.commit_retime();
+    }
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::repack(int idx) {
+    scan_bits_t d = dirty[idx];
+    if (!d) return;
+    // n planes show the top n bits of each channel, so a plane-count change
+    // only adds or drops the finest shades
+    int n = planes;
+    buf_planes[idx] = (uint8_t)n;
+    buf_dwell[idx] = (uint8_t)dwell;
+#if HUB75_PALETTE_FB
+    const uint8_t (*frame)[WIDTH / 2] = buffers[idx];
+    for (int row = 0; row < SCAN_ROWS; ++row) {
+        if (!(d & (1u << row))) continue;
+        const uint8_t *top = frame[row];
+        const uint8_t *bot = frame[row + SCAN_ROWS];
+        for (int plane = 0; plane < n; ++plane) {
+            const uint32_t *lt = pal_top[8 - n + plane], *lb = pal_bot[8 - n + plane];
+            uint32_t *words = packed[idx][plane][row];
+            for (int i = 0; i < WIDTH / 2; ++i) {
+                words[2 * i]     = lt[top[i] & 0x0F] | lb[bot[i] & 0x0F];
+                words[2 * i + 1] = lt[top[i] >> 4] | lb[bot[i] >> 4];
+            }
+        }
+    }
+#else
+    const uint8_t (*frame)[WIDTH][3] = buffers[idx];
+    for (int row = 0; row < SCAN_ROWS; ++row) {
+        if (!(d & (1u << row))) continue;
+        const uint8_t (*top)[3] = frame[row];
+        const uint8_t (*bot)[3] = frame[row + SCAN_ROWS];
+        for (int plane = 0; plane < n; ++plane) {
+            int bit = 8 - n + plane;
+            uint32_t *words = packed[idx][plane][row];
+            for (int col = 0; col < WIDTH; ++col) {
+                words[col] = ((uint32_t)((top[col][0] >> bit) & 1) << PIN_R1) |
+                             ((uint32_t)((top[col][1] >> bit) & 1) << PIN_G1) |
+                             ((uint32_t)((top[col][2] >> bit) & 1) << PIN_B1) |
+                             ((uint32_t)((bot[col][0] >> bit) & 1) << PIN_R2) |
+                             ((uint32_t)((bot[col][1] >> bit) & 1) << PIN_G2) |
+                             ((uint32_t)((bot[col][2] >> bit) & 1) << PIN_B2);
+            }
+        }
+    }
+#endif
+    dirty[idx] = 0;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::prepare_background_refresh() {
+    // start with both buffers showing the current frame
+    int front = swap.back_index() ^ 1;
+    int back = front ^ 1;
+    repack(draw_idx);
+    if (draw_idx != front) {
+        memcpy(buffers[front], fb, sizeof(buffers[0]));
+        memcpy(packed[front], packed[draw_idx], sizeof(packed[0]));
+        buf_planes[front] = buf_planes[draw_idx];
+        buf_dwell[front] = buf_dwell[draw_idx];
+        touched[front] = touched[draw_idx];
+        dirty[front] = 0;
+    }
+    if (draw_idx != back) {
+        memcpy(buffers[back], fb, sizeof(buffers[0]));
+        memcpy(packed[back], packed[draw_idx], sizeof(packed[0]));
+        buf_planes[back] = buf_planes[draw_idx];
+        buf_dwell[back] = buf_dwell[draw_idx];
+        touched[back] = touched[draw_idx];
+        dirty[back] = 0;
+    }
+    draw_idx = back;
+    fb = buffers[draw_idx];
+    reset_refresh_stats();
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::shift_row(const uint32_t *words) {
+    for (int col = 0; col < WIDTH; ++col) {
+        hal_gpio_put_masked(DATA_MASK, words[col]);
+        hal_gpio_set_mask(M_CLK);
+        hal_gpio_clr_mask(M_CLK);
+    }
+}
+
+#ifndef HOST_BUILD
+
+template <class Cfg>
+bool Hub75Panel<Cfg>::start_core1_refresh() {
+    if (mode != REFRESH_INLINE || refresh_owner) return false;
+    prepare_background_refresh();
+    refresh_owner = this;
+    mode = REFRESH_CORE1;
+    multicore_launch_core1(core1_entry);
+    return true;
+}
+
+template <class Cfg>
+bool Hub75Panel<Cfg>::start_timer_refresh() {
+    if (mode != REFRESH_INLINE || refresh_owner) return false;
+    int alarm = hardware_alarm_claim_unused(false);
+    if (alarm < 0) return false;
+    prepare_background_refresh();
+
+    // shift the first row; the first alarm lights it
+    bcm_front = swap.acquire_front();
+    bcm_planes = buf_planes[bcm_front];
+    bcm_dwell = buf_dwell[bcm_front];
+    bcm_plane = bcm_planes - 1;
+    bcm_row = 0;
+    hal_gpio_set_mask(M_OE);
+    shift_row(packed[bcm_front][bcm_plane][bcm_row]);
+
+    bcm_alarm = alarm;
+    refresh_owner = this;
+    mode = REFRESH_TIMER;
+    hardware_alarm_set_callback(alarm, bcm_alarm_cb);
+    hardware_alarm_set_target(alarm, make_timeout_time_us(100));
+    return true;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::bcm_alarm_cb(uint alarm_num) {
+    (void)alarm_num;
+    static_cast<Hub75Panel *>(refresh_owner)->bcm_step();
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::bcm_step() {
+    absolute_time_t target;
+    do {
+        // the previous row's dwell is over: latch and light the shifted row
+        hal_gpio_set_mask(M_OE);
+        set_row_address(bcm_row);
+        hal_gpio_set_mask(M_LAT);
+        hal_busy_wait_us(1);
+        hal_gpio_clr_mask(M_LAT);
+        hal_gpio_clr_mask(M_OE);
+        target = delayed_by_us(get_absolute_time(), (uint64_t)(1u << bcm_plane) * bcm_dwell);
+
+        // same plane/row order as scan_out; a new frame is picked up at the wrap
+        if (++bcm_row == SCAN_ROWS) {
+            bcm_row = 0;
+            if (--bcm_plane < 0) {
+                bcm_front = swap.acquire_front();
+                bcm_planes = buf_planes[bcm_front];
+                bcm_dwell = buf_dwell[bcm_front];
+                bcm_plane = bcm_planes - 1;
+                note_frame();
+            }
+        }
+        // shift the next row while this one is lit
+        shift_row(packed[bcm_front][bcm_plane][bcm_row]);
+        // short planes can be over before the shift is; light the next row at once
+    } while (hardware_alarm_set_target(bcm_alarm, target));
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::core1_entry() {
+    static_cast<Hub75Panel *>(refresh_owner)->core1_loop();
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::core1_loop() {
+    while (true) {
+        int front = swap.acquire_front();
+        scan_out(packed[front], buf_planes[front], buf_dwell[front]);
+        note_frame();
+    }
+}
+
+#else
+
+// Host: no second core or hardware alarm, the refresh stays inline
+template <class Cfg>
+bool Hub75Panel<Cfg>::start_core1_refresh() {
+    return false;
+}
+
+template <class Cfg>
+bool Hub75Panel<Cfg>::start_timer_refresh() {
+    return false;
+}
+
+#endif
+
+template <class Cfg>
+void Hub75Panel<Cfg>::note_frame() {
+    uint32_t now = hal_time_us();
+    if (stats.frames > 0) {
+        uint32_t period = now - last_frame_us;
+        stats.last_us = period;
+        if (period < stats.min_us) stats.min_us = period;
+        if (period > stats.max_us) stats.max_us = period;
+    }
+    last_frame_us = now;
+    stats.frames++;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::reset_refresh_stats() {
+    stats.frames = 0;
+    stats.last_us = 0;
+    stats.min_us = 0xFFFFFFFFu;
+    stats.max_us = 0;
+    last_frame_us = 0;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::scan_out(const uint32_t (*planes)[SCAN_ROWS][WIDTH], int n, int dwell_us) {
+    for (int plane = n - 1; plane >= 0; --plane) {
+        int us = (1 << plane) * dwell_us;
+        for (int row = 0; row < SCAN_ROWS; ++row) {
+            hal_gpio_set_mask(M_OE);
+            set_row_address(row);
+            shift_row(planes[plane][row]);
+
+            hal_gpio_set_mask(M_LAT);
+            hal_busy_wait_us(1);
+            hal_gpio_clr_mask(M_LAT);
+
+            hal_gpio_clr_mask(M_OE);
+            hal_busy_wait_us(us);
+
+            hal_gpio_set_mask(M_OE);
+        }
+    }
+}
+
+template <class Cfg>
+bool Hub75Panel<Cfg>::start_pio_refresh() {
+    if (mode != REFRESH_INLINE) return false;
+    pio_engine.set_planes(planes);
+    pack_pio(ALL_SCAN);
+    dirty[draw_idx] = 0;
+    if (!pio_engine.start(planes, dwell)) return false;
+    mode = REFRESH_PIO;
+    return true;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::stop_pio_refresh() {
+    if (mode != REFRESH_PIO) return;
+    pio_engine.stop();
+    mode = REFRESH_INLINE;
+    // packed words were not maintained while PIO was running
+    dirty[draw_idx] = ALL_SCAN;
+}
+
+template <class Cfg>
+void Hub75Panel<Cfg>::set_row_address(int row) {
+    hal_gpio_put_masked(ADDR_MASK, ROW_ADDR<Cfg>.mask[row]);
+}
+
+template class Hub75Panel<Hub75Config32x32>;
+template class Hub75Panel<Hub75Config64x32>;
+template class Hub75Panel<Hub75Config64x64>;
+template class Hub75Panel<Hub75Config64x32x2>;
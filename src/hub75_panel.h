@@ -0,0 +1,227 @@
+// hub75_panel.h - framebuffer, drawing and refresh for a HUB75 panel
+//
+// Hub75Panel<Cfg> is the whole driver for one panel geometry (see
+// hub75_config.h). Definitions live in hub75_panel.cpp, which instantiates the
+// configurations declared there; add a line to it for a new geometry.
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include "hal.h"
+#include "hub75_config.h"
+#include "hub75_pio.h"
+#include "frame_swap.h"
+#include "refresh_governor.h"
+
+// Framebuffer format: 0 = 8-bit R, G, B per pixel (3 KB per 32x32 buffer), 1 =
+// 4-bit palette index per pixel (512 bytes), expanded through the palette
+// only when planes are packed. Override with -DHUB75_PALETTE_FB=1 in build flags.
+#ifndef HUB75_PALETTE_FB
+#define HUB75_PALETTE_FB 0
+#endif
+
+// Geometry-independent part, shared by every instantiation
+class Hub75PanelBase {
+public:
+    // Who keeps the panel lit: refresh_once() itself, the PIO/DMA engine,
+    // core 1, or the hardware-alarm BCM interrupt
+    enum RefreshMode { REFRESH_INLINE, REFRESH_PIO, REFRESH_CORE1, REFRESH_TIMER };
+
+    // Refresh timing, updated by whichever core scans out the panel
+    struct RefreshStats {
+        uint32_t frames;
+        uint32_t last_us;
+        uint32_t min_us;
+        uint32_t max_us;
+    };
+
+    // Bit planes and plane-0 dwell in use, and the governor's target and
+    // last measurement (target 0 = governor off)
+    struct RefreshTiming {
+        int planes;
+        int dwell_us;
+        uint32_t target_hz;
+        uint32_t measured_hz;
+    };
+};
+
+template <class Cfg>
+class Hub75Panel : public Hub75PanelBase {
+    typedef typename Cfg::Pins Pins;
+
+public:
+    static constexpr int WIDTH = Cfg::WIDTH;
+    static constexpr int HEIGHT = Cfg::HEIGHT;
+    static constexpr int SCAN_ROWS = Cfg::SCAN_ROWS;
+    static constexpr int ADDR_PINS = Cfg::ADDR_PINS;
+
+    // Pin definitions
+    static constexpr uint PIN_R1 = Pins::R1;
+    static constexpr uint PIN_G1 = Pins::G1;
+    static constexpr uint PIN_B1 = Pins::B1;
+    static constexpr uint PIN_R2 = Pins::R2;
+    static constexpr uint PIN_G2 = Pins::G2;
+    static constexpr uint PIN_B2 = Pins::B2;
+    static constexpr uint PIN_CLK= Pins::CLK;
+    static constexpr uint PIN_OE = Pins::OE;
+    static constexpr uint PIN_LAT= Pins::LAT;
+
+    // masks
+    static constexpr uint32_t M_R1 = 1u << PIN_R1;
+    static constexpr uint32_t M_G1 = 1u << PIN_G1;
+    static constexpr uint32_t M_B1 = 1u << PIN_B1;
+    static constexpr uint32_t M_R2 = 1u << PIN_R2;
+    static constexpr uint32_t M_G2 = 1u << PIN_G2;
+    static constexpr uint32_t M_B2 = 1u << PIN_B2;
+    static constexpr uint32_t M_CLK= 1u << PIN_CLK;
+    static constexpr uint32_t M_LAT= 1u << PIN_LAT;
+    static constexpr uint32_t M_OE = 1u << PIN_OE;
+    static constexpr uint32_t DATA_MASK = M_R1|M_G1|M_B1|M_R2|M_G2|M_B2;
+    static constexpr uint32_t ADDR_MASK = (1u << Pins::ADDR[0]) | (1u << Pins::ADDR[1]) | (1u << Pins::ADDR[2]) |
+                                          (ADDR_PINS > 3 ? 1u << Pins::ADDR[3] : 0u) |
+                                          (ADDR_PINS > 4 ? 1u << Pins::ADDR[4] : 0u);
+
+    // Refresh tuning. Plane p of n shows bit 8 - n + p of each channel for
+    // DWELL << p us. These are the starting point; set_min_refresh_hz() lets
+    // the governor trade planes (color depth) and dwell against refresh rate.
+    static constexpr int MAX_BITPLANES = 8;
+    static constexpr int MIN_BITPLANES = 3;
+    static constexpr int BITPLANES = 5; // fewer planes -> faster refresh
+    static constexpr int DWELL_SCALE = 4; // smaller dwell -> faster refresh
+
+    // One bit per panel row (touched) and per scan address (dirty); the
+    // 32x32 panel keeps its 32/16-bit masks
+    typedef typename std::conditional<(HEIGHT > 32), uint64_t, uint32_t>::type row_bits_t;
+    typedef typename std::conditional<(SCAN_ROWS > 16), uint32_t, uint16_t>::type scan_bits_t;
+    static constexpr row_bits_t ALL_ROWS = (row_bits_t)~(row_bits_t)0;
+    static constexpr scan_bits_t ALL_SCAN = (scan_bits_t)~(scan_bits_t)0;
+
+    // framebuffers: fb points at the one being drawn. With core 1 refresh
+    // running it is the back buffer and the other one is being scanned out.
+#if HUB75_PALETTE_FB
+    // Two pixels per byte, even column in the low nibble; index 0 is black
+    static constexpr int PALETTE_SIZE = 16;
+    alignas(4) uint8_t buffers[2][HEIGHT][WIDTH / 2];
+    uint8_t (*fb)[WIDTH / 2];
+#else
+    alignas(4) uint8_t buffers[2][HEIGHT][WIDTH][3];
+    uint8_t (*fb)[WIDTH][3];
+#endif
+
+    // Ready-to-write GPIO data words for each buffer, plane, row pair and
+    // column. Only row pairs marked dirty by set_pixel/clear are repacked.
+    uint32_t packed[2][MAX_BITPLANES][SCAN_ROWS][WIDTH];
+
+    Hub75Panel();
+    void set_pixel(int x, int y, uint8_t r, uint8_t g, uint8_t b);
+    // Set the pixels of row y whose bit is set in mask (bit i = column x0 + i)
+    void set_row_mask(int y, uint32_t mask, uint8_t r, uint8_t g, uint8_t b, int x0 = 0);
+    void clear();
+
+    // Span primitives: clip once per call, then fill whole runs with word
+    // stores. src in blit() is RGB pixels, src_stride pixels per row; with
+    // keyed set, black source pixels are transparent.
+    void hline(int x, int y, int w, uint8_t r, uint8_t g, uint8_t b);
+    void fill_rect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b);
+    void blit(int x, int y, int w, int h, const uint8_t (*src)[3], int src_stride, bool keyed = false);
+
+    // Same without clipping, for callers that know the area is on the panel
+    void hline_unchecked(int x, int y, int w, uint8_t r, uint8_t g, uint8_t b);
+    void fill_rect_unchecked(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b);
+    void blit_unchecked(int x, int y, int w, int h, const uint8_t (*src)[3], int src_stride, bool keyed = false);
+    void refresh_once();
+
+    // Buffer currently drawn into and how many times it has been cleared.
+    // Incremental renderers use these to tell whether their last frame in
+    // this buffer is still intact.
+    int draw_buffer() const { return draw_idx; }
+    uint32_t clear_count() const { return clears[draw_idx]; }
+
+    // Hand refresh over to the PIO/DMA engine. While it runs, refresh_once()
+    // only repacks fb into plane buffers; the panel stays lit on its own.
+    bool start_pio_refresh();
+    void stop_pio_refresh();
+
+    // Run the refresh loop on core 1 against a front buffer. While it runs,
+    // refresh_once() publishes the drawn frame and swaps buffers once core 1
+    // reaches a frame boundary.
+    bool start_core1_refresh();
+
+    // Drive binary code modulation from a hardware alarm IRQ. Each interrupt
+    // lights the row shifted in last time and shifts the next one while it is
+    // lit, so the CPU only works at plane boundaries and is free during the
+    // dwell. Frames are handed over as with core 1 refresh.
+    bool start_timer_refresh();
+
+    RefreshMode refresh_mode() const { return mode; }
+
+    // Stats are read unsynchronized from the other core; fine for reporting
+    RefreshStats refresh_stats() const { return stats; }
+    void reset_refresh_stats();
+
+    // Hold at least hz refreshes per second by adapting planes and dwell,
+    // re-evaluated from refresh_once(); 0 keeps the current setting
+    void set_min_refresh_hz(uint32_t hz);
+    RefreshTiming refresh_timing() const;
+
+#if HUB75_PALETTE_FB
+    // Colors passed to the drawing calls are mapped to an entry that matches
+    // exactly, else a free one, else the nearest. Changing an entry recolors
+    // every pixel using it at the next repack.
+    uint8_t palette_index(uint8_t r, uint8_t g, uint8_t b);
+    void set_palette(int i, uint8_t r, uint8_t g, uint8_t b);
+#endif
+
+private:
+    Hub75PioEngine<Cfg> pio_engine;
+    FrameSwap swap;
+    volatile RefreshMode mode;
+    RefreshStats stats;
+    uint32_t last_frame_us;
+
+    int draw_idx;           // index of fb in buffers/packed
+    scan_bits_t dirty[2];   // row pairs (y % SCAN_ROWS) whose packed words are stale
+    row_bits_t touched[2];  // fb rows written since the last clear()
+    uint32_t clears[2];     // clear() calls per buffer
+
+    // Planes/dwell new packing uses, and what each buffer was packed with
+    // (the scanner reads its front buffer's)
+    int planes, dwell;
+    uint8_t buf_planes[2], buf_dwell[2];
+    RefreshGovernor governor;
+    uint32_t governed_frames; // stats.frames at the last governor sample
+
+#if HUB75_PALETTE_FB
+    uint8_t palette[PALETTE_SIZE][3];
+    uint16_t palette_used;  // entries handed out by palette_index()
+    // GPIO data bits of each entry per plane, for the top and bottom half
+    // (indexed by color bit)
+    uint32_t pal_top[MAX_BITPLANES][PALETTE_SIZE];
+    uint32_t pal_bot[MAX_BITPLANES][PALETTE_SIZE];
+    void put_index(int x, int y, uint8_t idx);
+    void fill_index(int x, int y, int w, uint8_t idx);
+#endif
+
+    // timer BCM state, owned by the alarm IRQ once running
+    int bcm_alarm;
+    int bcm_front;
+    int bcm_planes, bcm_dwell; // the front buffer's
+    int bcm_plane, bcm_row; // row currently sitting in the shift register
+
+    static void core1_entry();
+    void core1_loop();
+    static void bcm_alarm_cb(uint alarm_num);
+    void bcm_step();
+    void shift_row(const uint32_t *words);
+    void prepare_background_refresh();
+    void repack(int idx);
+    void scan_out(const uint32_t (*planes)[SCAN_ROWS][WIDTH], int n, int dwell_us);
+    void govern();
+    void apply_timing(RefreshGovernor::Setting s);
+    void note_frame();
+    void set_row_address(int row);
+    void mark_rows(int y, int h);
+    void pack_pio(scan_bits_t row_mask);
+    static bool clip(int &x, int &y, int &w, int &h, int *sx = nullptr, int *sy = nullptr);
+};
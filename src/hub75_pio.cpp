@@ -0,0 +1,420 @@
+// hub75_pio.cpp - PIO/DMA HUB75 refresh engine and its host stand-in
+
+#include "hub75_pio.h"
+#include <cstring>
+
+#ifndef HOST_BUILD
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#endif
+
+template <class Cfg>
+Hub75PioEngine<Cfg> *Hub75PioEngine<Cfg>::irq_owner = nullptr;
+
+template <class Cfg>
+Hub75PioEngine<Cfg>::Hub75PioEngine() {
+    num_planes = MAX_PLANES;
+    dwell = 1;
+    sys_mhz = 150;
+    cycles_per_us = 1;
+    active = false;
+    bank = shown = 0;
+    bank_planes[0] = bank_planes[1] = MAX_PLANES;
+    switch_pending = false;
+    data_sm = row_sm = -1;
+    data_offset = row_offset = -1;
+    data_chan = data_ctrl_chan = row_chan = row_ctrl_chan = -1;
+    data_start = plane_data[0];
+    row_start = row_ctrl[0];
+    memset(plane_data, 0, sizeof(plane_data));
+    memset(row_ctrl, 0, sizeof(row_ctrl));
+}
+
+template <class Cfg>
+void Hub75PioEngine<Cfg>::pack(const uint8_t fb[HEIGHT][WIDTH][3], uint32_t row_mask) {
+    for (int plane = 0; plane < num_planes; ++plane) {
+        int bit = 8 - num_planes + plane;
+        for (int row = 0; row < SCAN_ROWS; ++row) {
+            if (!(row_mask & (1u << row))) continue;
+            const uint8_t (*top)[3] = fb[row];
+            const uint8_t (*bot)[3] = fb[row + SCAN_ROWS];
+            uint8_t *out = plane_data[bank][plane][row];
+            for (int col = 0; col < WIDTH; ++col) {
+                uint8_t v = 0;
+                if ((top[col][0] >> bit) & 1) v |= BIT_R1;
+                if ((top[col][1] >> bit) & 1) v |= BIT_G1;
+                if ((top[col][2] >> bit) & 1) v |= BIT_B1;
+                if ((bot[col][0] >> bit) & 1) v |= BIT_R2;
+                if ((bot[col][1] >> bit) & 1) v |= BIT_G2;
+                if ((bot[col][2] >> bit) & 1) v |= BIT_B2;
+                out[col] = v;
+            }
+        }
+    }
+}
+
+template <class Cfg>
+void Hub75PioEngine<Cfg>::pack(const uint8_t fb[HEIGHT][WIDTH / 2], const uint8_t palette[16][3], uint32_t row_mask) {
+    for (int plane = 0; plane < num_planes; ++plane) {
+        // column bits of each palette entry for this plane, as a top pixel
+        int bit = 8 - num_planes + plane;
+        uint8_t top_bits[16];
+        for (int i = 0; i < 16; ++i) {
+            top_bits[i] = (uint8_t)((((palette[i][0] >> bit) & 1) ? BIT_R1 : 0) |
+                                    (((palette[i][1] >> bit) & 1) ? BIT_G1 : 0) |
+                                    (((palette[i][2] >> bit) & 1) ? BIT_B1 : 0));
+        }
+        for (int row = 0; row < SCAN_ROWS; ++row) {
+            if (!(row_mask & (1u << row))) continue;
+            const uint8_t *top = fb[row];
+            const uint8_t *bot = fb[row + SCAN_ROWS];
+            uint8_t *out = plane_data[bank][plane][row];
+            // R2/G2/B2 sit 3 bits below R1/G1/B1
+            for (int i = 0; i < WIDTH / 2; ++i) {
+                out[2 * i]     = top_bits[top[i] & 0x0F] | (top_bits[bot[i] & 0x0F] >> 3);
+                out[2 * i + 1] = top_bits[top[i] >> 4] | (top_bits[bot[i] >> 4] >> 3);
+            }
+        }
+    }
+}
+
+template <class Cfg>
+void Hub75PioEngine<Cfg>::set_planes(int planes) {
+    if (planes < 1) planes = 1;
+    if (planes > MAX_PLANES) planes = MAX_PLANES;
+    num_planes = planes;
+    bank_planes[bank] = (uint8_t)planes;
+}
+
+template <class Cfg>
+bool Hub75PioEngine<Cfg>::retime(int planes, int dwell_us) {
+    if (switch_pending) return false;
+    // while running, the spare bank; stopped, either will do
+    if (active) bank = shown ^ 1;
+    set_planes(planes);
+    dwell = dwell_us;
+    build_row_ctrl(dwell_us * (int)cycles_per_us);
+    return true;
+}
+
+template <class Cfg>
+void Hub75PioEngine<Cfg>::commit_retime() {
+    if (bank == shown) return;
+#ifndef HOST_BUILD
+    if (active) {
+        // a stale completion flag would fire at once instead of at the next boundary
+        switch_pending = true;
+        dma_hw->ints1 = 1u << data_ctrl_chan;
+        dma_channel_set_irq1_enabled(data_ctrl_chan, true);
+        return;
+    }
+#endif
+    switch_banks();
+}
+
+// Point the control words and reload counts at the pack bank; the chains
+// load them when they next restart
+template <class Cfg>
+void Hub75PioEngine<Cfg>::switch_banks() {
+    data_start = plane_data[bank];
+    row_start = row_ctrl[bank];
+#ifndef HOST_BUILD
+    if (active) {
+        // TRANS_COUNT writes only set the reload value for the next trigger
+        dma_channel_set_trans_count(data_chan, bank_planes[bank] * SCAN_ROWS * WIDTH / 4, false);
+        dma_channel_set_trans_count(row_chan, bank_planes[bank] * SCAN_ROWS, false);
+    }
+#endif
+    shown = bank;
+    switch_pending = false;
+}
+
+template <class Cfg>
+uint32_t Hub75PioEngine<Cfg>::frame_us() const {
+    // 2 data SM cycles per column, plus a few row SM cycles around the latch
+    uint32_t shift_ns = (uint32_t)(WIDTH * 2 * DATA_CLKDIV * 1000.0f) / sys_mhz;
+    uint32_t latch_ns = 8000u / sys_mhz;
+    uint64_t ns = 0;
+    for (int plane = 0; plane < num_planes; ++plane) {
+        uint32_t lit_ns = ((uint32_t)dwell << plane) * 1000u + latch_ns;
+        ns += (uint64_t)SCAN_ROWS * (lit_ns > shift_ns ? lit_ns : shift_ns);
+    }
+    return (uint32_t)(ns / 1000);
+}
+
+template <class Cfg>
+void Hub75PioEngine<Cfg>::build_row_ctrl(int dwell_cycles_per_unit) {
+    for (int plane = 0; plane < num_planes; ++plane) {
+        uint32_t cycles = (uint32_t)dwell_cycles_per_unit << plane;
+        if (cycles == 0) cycles = 1;
+        for (int row = 0; row < SCAN_ROWS; ++row) {
+            row_ctrl[bank][plane][row] = ((cycles - 1) << ADDR_PINS) | (uint32_t)row;
+        }
+    }
+}
+
+template <class Cfg>
+void Hub75PioEngine<Cfg>::emulate_frame(PinSink sink, void *ctx) const {
+    uint32_t pins = OE_GPIO_MASK; // blanked, as after reset
+    for (int plane = 0; plane < bank_planes[shown]; ++plane) {
+        for (int row = 0; row < SCAN_ROWS; ++row) {
+            // data SM: one byte per column, CLK low with data then CLK high
+            const uint8_t *cols = plane_data[shown][plane][row];
+            for (int col = 0; col < WIDTH; ++col) {
+                pins = (pins & ~(DATA_GPIO_MASK | CLK_GPIO_MASK)) | ((uint32_t)cols[col] << DATA_BASE);
+                sink(pins, 0, ctx);
+                pins |= CLK_GPIO_MASK;
+                sink(pins, 0, ctx);
+            }
+            pins &= ~CLK_GPIO_MASK;
+
+            // row SM: address with OE high, LAT pulse, then OE low for the dwell
+            uint32_t word = row_ctrl[shown][plane][row];
+            pins = (pins & ~ADDR_GPIO_MASK) | ((word & ((1u << ADDR_PINS) - 1)) << ADDR_BASE) | OE_GPIO_MASK;
+            sink(pins, 0, ctx);
+            sink(pins | LAT_GPIO_MASK, 0, ctx);
+            pins &= ~OE_GPIO_MASK;
+            sink(pins, (word >> ADDR_PINS) + 1, ctx);
+            pins |= OE_GPIO_MASK;
+        }
+    }
+    sink(pins, 0, ctx);
+}
+
+#ifdef HOST_BUILD
+
+// Host stand-in: no hardware, dwell counted in microseconds (1 cycle per us)
+template <class Cfg>
+bool Hub75PioEngine<Cfg>::start(int planes, int dwell_us) {
+    set_planes(planes);
+    dwell = dwell_us;
+    build_row_ctrl(dwell_us);
+    switch_banks();
+    active = true;
+    return true;
+}
+
+template <class Cfg>
+void Hub75PioEngine<Cfg>::stop() {
+    active = false;
+}
+
+#else
+
+#define HUB75_PIO pio0
+
+// data SM: side-set CLK, Y holds WIDTH-1 (loaded once in start())
+//   mov x, y        side 0
+// col:
+//   out pins, 8     side 0   ; 6 data pins, top 2 bits dropped
+//   jmp x-- col     side 1   ; rising CLK edge
+//   irq set 4       side 0   ; row shifted
+//   wait 1 irq 5    side 0   ; until row SM has latched it
+static constexpr int DATA_PROG_LEN = 5;
+
+// row SM: side-set {LAT, OE}, one 32-bit word per row
+//   out pins, 4     side 0b01      ; row address, blanked
+//   out x, 28       side 0b01      ; dwell
+//   wait 1 irq 4    side 0b01      ; data SM done shifting
+//   nop             side 0b11 [3]  ; LAT pulse
+//   irq set 5       side 0b01      ; data SM may shift the next row
+// lit:
+//   jmp x-- lit     side 0b00      ; OE low for x+1 cycles
+static constexpr int ROW_PROG_LEN = 6;
+
+template <class Cfg>
+bool Hub75PioEngine<Cfg>::start(int planes, int dwell_us) {
+    if (active) return true;
+    set_planes(planes);
+    dwell = dwell_us;
+    sys_mhz = clock_get_hz(clk_sys) / 1000000;
+    cycles_per_us = sys_mhz;
+    build_row_ctrl(dwell_us * (int)sys_mhz);
+    switch_banks();
+
+    PIO pio = HUB75_PIO;
+    data_sm = pio_claim_unused_sm(pio, false);
+    row_sm = pio_claim_unused_sm(pio, false);
+    if (data_sm < 0 || row_sm < 0) {
+        if (data_sm >= 0) pio_sm_unclaim(pio, data_sm);
+        if (row_sm >= 0) pio_sm_unclaim(pio, row_sm);
+        data_sm = row_sm = -1;
+        return false;
+    }
+
+    uint16_t data_insns[DATA_PROG_LEN] = {
+        (uint16_t)(pio_encode_mov(pio_x, pio_y) | pio_encode_sideset(1, 0)),
+        (uint16_t)(pio_encode_out(pio_pins, 8) | pio_encode_sideset(1, 0)),
+        (uint16_t)(pio_encode_jmp_x_dec(1) | pio_encode_sideset(1, 1)),
+        (uint16_t)(pio_encode_irq_set(false, 4) | pio_encode_sideset(1, 0)),
+        (uint16_t)(pio_encode_wait_irq(true, false, 5) | pio_encode_sideset(1, 0)),
+    };
+    uint16_t row_insns[ROW_PROG_LEN] = {
+        (uint16_t)(pio_encode_out(pio_pins, ADDR_PINS) | pio_encode_sideset(2, 1)),
+        (uint16_t)(pio_encode_out(pio_x, 32 - ADDR_PINS) | pio_encode_sideset(2, 1)),
+        (uint16_t)(pio_encode_wait_irq(true, false, 4) | pio_encode_sideset(2, 1)),
+        (uint16_t)(pio_encode_nop() | pio_encode_sideset(2, 3) | pio_encode_delay(3)),
+        (uint16_t)(pio_encode_irq_set(false, 5) | pio_encode_sideset(2, 1)),
+        (uint16_t)(pio_encode_jmp_x_dec(5) | pio_encode_sideset(2, 0)),
+    };
+    pio_program data_prog = { data_insns, DATA_PROG_LEN, -1 };
+    pio_program row_prog = { row_insns, ROW_PROG_LEN, -1 };
+    data_offset = pio_add_program(pio, &data_prog);
+    row_offset = pio_add_program(pio, &row_prog);
+
+    for (unsigned p = 0; p < DATA_PINS; ++p) pio_gpio_init(pio, DATA_BASE + p);
+    for (unsigned p = 0; p < ADDR_PINS; ++p) pio_gpio_init(pio, ADDR_BASE + p);
+    pio_gpio_init(pio, PIN_CLK);
+    pio_gpio_init(pio, PIN_LAT);
+    pio_gpio_init(pio, PIN_OE);
+
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_out_pins(&c, DATA_BASE, DATA_PINS);
+    sm_config_set_sideset_pins(&c, PIN_CLK);
+    sm_config_set_sideset(&c, 1, false, false);
+    sm_config_set_out_shift(&c, true, true, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, DATA_CLKDIV);
+    sm_config_set_wrap(&c, data_offset, data_offset + DATA_PROG_LEN - 1);
+    pio_sm_set_consecutive_pindirs(pio, data_sm, DATA_BASE, DATA_PINS, true);
+    pio_sm_set_consecutive_pindirs(pio, data_sm, PIN_CLK, 1, true);
+    pio_sm_init(pio, data_sm, data_offset, &c);
+    // Y = columns per row - 1; the OSR is emptied again so the first OUT autopulls
+    pio_sm_put_blocking(pio, data_sm, WIDTH - 1);
+    pio_sm_exec(pio, data_sm, pio_encode_pull(false, true));
+    pio_sm_exec(pio, data_sm, pio_encode_out(pio_y, 32));
+
+    c = pio_get_default_sm_config();
+    sm_config_set_out_pins(&c, ADDR_BASE, ADDR_PINS);
+    sm_config_set_sideset_pins(&c, PIN_OE);
+    sm_config_set_sideset(&c, 2, false, false);
+    sm_config_set_out_shift(&c, true, true, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, 1.0f);
+    sm_config_set_wrap(&c, row_offset, row_offset + ROW_PROG_LEN - 1);
+    pio_sm_set_consecutive_pindirs(pio, row_sm, ADDR_BASE, ADDR_PINS, true);
+    pio_sm_set_consecutive_pindirs(pio, row_sm, PIN_OE, 2, true);
+    pio_sm_init(pio, row_sm, row_offset, &c);
+
+    // clear the handshake flags left over from a previous run
+    pio->irq = (1u << 4) | (1u << 5);
+
+    // data/row channels stream the buffers; each one chains into a control
+    // channel that rewrites its read address (which retriggers it)
+    data_chan = dma_claim_unused_channel(true);
+    data_ctrl_chan = dma_claim_unused_channel(true);
+    row_chan = dma_claim_unused_channel(true);
+    row_ctrl_chan = dma_claim_unused_channel(true);
+    data_start = plane_data[shown];
+    row_start = row_ctrl[shown];
+
+    dma_channel_config dc = dma_channel_get_default_config(data_chan);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, false);
+    channel_config_set_dreq(&dc, pio_get_dreq(pio, data_sm, true));
+    channel_config_set_chain_to(&dc, data_ctrl_chan);
+    dma_channel_configure(data_chan, &dc, &pio->txf[data_sm], data_start,
+                          num_planes * SCAN_ROWS * WIDTH / 4, false);
+
+    dma_channel_config dcc = dma_channel_get_default_config(data_ctrl_chan);
+    channel_config_set_transfer_data_size(&dcc, DMA_SIZE_32);
+    channel_config_set_read_increment(&dcc, false);
+    channel_config_set_write_increment(&dcc, false);
+    dma_channel_configure(data_ctrl_chan, &dcc, &dma_hw->ch[data_chan].al3_read_addr_trig,
+                          &data_start, 1, false);
+
+    dma_channel_config rc = dma_channel_get_default_config(row_chan);
+    channel_config_set_transfer_data_size(&rc, DMA_SIZE_32);
+    channel_config_set_read_increment(&rc, true);
+    channel_config_set_write_increment(&rc, false);
+    channel_config_set_dreq(&rc, pio_get_dreq(pio, row_sm, true));
+    channel_config_set_chain_to(&rc, row_ctrl_chan);
+    dma_channel_configure(row_chan, &rc, &pio->txf[row_sm], row_start,
+                          num_planes * SCAN_ROWS, false);
+
+    dma_channel_config rcc = dma_channel_get_default_config(row_ctrl_chan);
+    channel_config_set_transfer_data_size(&rcc, DMA_SIZE_32);
+    channel_config_set_read_increment(&rcc, false);
+    channel_config_set_write_increment(&rcc, false);
+    dma_channel_configure(row_ctrl_chan, &rcc, &dma_hw->ch[row_chan].al3_read_addr_trig,
+                          &row_start, 1, false);
+
+    // frame-boundary interrupt for retiming; enabled per switch only
+    irq_owner = this;
+    irq_add_shared_handler(DMA_IRQ_1, frame_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_start_channel_mask((1u << data_ctrl_chan) | (1u << row_ctrl_chan));
+    pio_set_sm_mask_enabled(pio, (1u << data_sm) | (1u << row_sm), true);
+    active = true;
+    return true;
+}
+
+// The data control channel completing means the data chain has just
+// restarted. The row chain runs up to a joined FIFO (8 rows) ahead of it, so
+// it has restarted too: words written now are picked up by both at the same
+// next boundary.
+template <class Cfg>
+void Hub75PioEngine<Cfg>::frame_irq() {
+    Hub75PioEngine *e = irq_owner;
+    if (!e || !e->active) return;
+    uint32_t mask = 1u << e->data_ctrl_chan;
+    if (!(dma_hw->ints1 & mask)) return;
+    dma_hw->ints1 = mask;
+    dma_channel_set_irq1_enabled(e->data_ctrl_chan, false);
+    if (e->switch_pending) e->switch_banks();
+}
+
+template <class Cfg>
+void Hub75PioEngine<Cfg>::stop() {
+    if (!active) return;
+    PIO pio = HUB75_PIO;
+    dma_channel_set_irq1_enabled(data_ctrl_chan, false);
+    irq_remove_handler(DMA_IRQ_1, frame_irq);
+    irq_owner = nullptr;
+    // stop the SMs first so DREQ stalls the data channels mid-buffer and
+    // they can't complete and chain back into the control channels
+    pio_set_sm_mask_enabled(pio, (1u << data_sm) | (1u << row_sm), false);
+    dma_channel_abort(data_ctrl_chan);
+    dma_channel_abort(row_ctrl_chan);
+    dma_channel_abort(data_chan);
+    dma_channel_abort(row_chan);
+    dma_channel_unclaim(data_chan);
+    dma_channel_unclaim(data_ctrl_chan);
+    dma_channel_unclaim(row_chan);
+    dma_channel_unclaim(row_ctrl_chan);
+
+    pio_program data_prog = { nullptr, DATA_PROG_LEN, -1 };
+    pio_program row_prog = { nullptr, ROW_PROG_LEN, -1 };
+    pio_remove_program(pio, &data_prog, data_offset);
+    pio_remove_program(pio, &row_prog, row_offset);
+    pio_sm_unclaim(pio, data_sm);
+    pio_sm_unclaim(pio, row_sm);
+
+    // hand the pins back to SIO, blanked
+    for (unsigned p = 0; p < DATA_PINS; ++p) gpio_init(DATA_BASE + p);
+    for (unsigned p = 0; p < ADDR_PINS; ++p) gpio_init(ADDR_BASE + p);
+    gpio_init(PIN_CLK);
+    gpio_init(PIN_LAT);
+    gpio_init(PIN_OE);
+    gpio_set_dir_out_masked(DATA_GPIO_MASK | ADDR_GPIO_MASK | CLK_GPIO_MASK | LAT_GPIO_MASK | OE_GPIO_MASK);
+    gpio_clr_mask(DATA_GPIO_MASK | ADDR_GPIO_MASK | CLK_GPIO_MASK | LAT_GPIO_MASK);
+    gpio_set_mask(OE_GPIO_MASK);
+
+    data_sm = row_sm = -1;
+    data_chan = data_ctrl_chan = row_chan = row_ctrl_chan = -1;
+    active = false;
+    // a switch still pending takes effect on the next start
+    if (switch_pending) switch_banks();
+}
+
+#endif
+
+template class Hub75PioEngine<Hub75Config32x32>;
+template class Hub75PioEngine<Hub75Config64x32>;
+template class Hub75PioEngine<Hub75Config64x64>;
+template class Hub75PioEngine<Hub75Config64x32x2>;
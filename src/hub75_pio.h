@@ -0,0 +1,133 @@
+// hub75_pio.h - PIO + chained DMA refresh backend for HUB75 panels
+//
+// Two state machines share the panel: the data SM clocks one byte per column
+// out of a pre-packed plane buffer, the row SM sets the row address, pulses LAT
+// and holds OE low for the plane's dwell. Both are fed by DMA channels that are
+// re-armed by a control channel, so once started the panel refreshes forever
+// without the CPU.
+//
+// The packed data and row words are double-banked so the plane count and
+// dwell can change while running: retime() switches pack() to the spare
+// bank, and after commit_retime() a one-shot DMA interrupt at the next frame
+// boundary points both chains at it. The panel never blanks.
+//
+// Templated on a Hub75Config; hub75_pio.cpp instantiates the configurations
+// in hub75_config.h.
+
+#pragma once
+
+#include <cstdint>
+#include "hub75_config.h"
+
+template <class Cfg>
+class Hub75PioEngine {
+    typedef typename Cfg::Pins Pins;
+
+public:
+    // Pin layout the PIO programs rely on (contiguous groups)
+    static constexpr unsigned DATA_BASE = Pins::B2; // B2,G2,R2,B1,G1,R1 = DATA_BASE..+5
+    static constexpr unsigned DATA_PINS = 6;
+    static constexpr unsigned ADDR_BASE = Pins::ADDR[0];
+    static constexpr unsigned ADDR_PINS = Cfg::ADDR_PINS;
+    static constexpr unsigned PIN_OE  = Pins::OE;   // sideset bit 0 of the row SM
+    static constexpr unsigned PIN_LAT = Pins::LAT;  // sideset bit 1 of the row SM
+    static constexpr unsigned PIN_CLK = Pins::CLK;  // sideset of the data SM
+
+    static_assert(Pins::G2 == DATA_BASE + 1 && Pins::R2 == DATA_BASE + 2 && Pins::B1 == DATA_BASE + 3 &&
+                  Pins::G1 == DATA_BASE + 4 && Pins::R1 == DATA_BASE + 5,
+                  "HUB75 data pins must be GPIO DATA_BASE..DATA_BASE+5 (B2,G2,R2,B1,G1,R1)");
+    static_assert(Pins::ADDR[1] == ADDR_BASE + 1 && Pins::ADDR[2] == ADDR_BASE + 2 &&
+                  (ADDR_PINS < 4 || Pins::ADDR[3] == ADDR_BASE + 3) &&
+                  (ADDR_PINS < 5 || Pins::ADDR[4] == ADDR_BASE + 4),
+                  "HUB75 address pins must be contiguous");
+    static_assert(PIN_LAT == PIN_OE + 1, "HUB75 LAT must be the GPIO above OE (row SM sideset)");
+
+    // Bits of one packed column byte (bit n drives GPIO DATA_BASE + n)
+    static constexpr uint8_t BIT_B2 = 1u << 0;
+    static constexpr uint8_t BIT_G2 = 1u << 1;
+    static constexpr uint8_t BIT_R2 = 1u << 2;
+    static constexpr uint8_t BIT_B1 = 1u << 3;
+    static constexpr uint8_t BIT_G1 = 1u << 4;
+    static constexpr uint8_t BIT_R1 = 1u << 5;
+
+    static constexpr int WIDTH = Cfg::WIDTH;
+    static constexpr int HEIGHT = Cfg::HEIGHT;
+    static constexpr int SCAN_ROWS = Cfg::SCAN_ROWS;
+    static constexpr int MAX_PLANES = 8;
+    static constexpr uint32_t ALL_ROWS = SCAN_ROWS == 32 ? 0xFFFFFFFFu : (1u << SCAN_ROWS) - 1;
+
+    // Data SM runs at sys_clk / DATA_CLKDIV and takes 2 cycles per column
+    static constexpr float DATA_CLKDIV = 4.0f;
+
+    Hub75PioEngine();
+
+    // Pack an RGB framebuffer into the pack bank: with n planes, plane p holds
+    // bit 8 - n + p of each channel (the top n bits). row_mask selects the row
+    // pairs (y % SCAN_ROWS) to repack.
+    void pack(const uint8_t fb[HEIGHT][WIDTH][3], uint32_t row_mask = ALL_ROWS);
+    // Same from 4-bit palette indices (even column in the low nibble)
+    void pack(const uint8_t fb[HEIGHT][WIDTH / 2], const uint8_t palette[16][3], uint32_t row_mask = ALL_ROWS);
+
+    // Claim PIO/DMA resources and start continuous refresh. dwell_us is the
+    // on-time of plane 0; plane n is lit for dwell_us << n.
+    bool start(int planes, int dwell_us);
+    void stop();
+    bool running() const { return active; }
+
+    // Plane count pack() works with; start() sets it too. Call before packing
+    // for a (re)start with a different count.
+    void set_planes(int planes);
+
+    // Timing change while running. retime() moves pack() to the spare bank
+    // with the new timing; pack every row, then commit_retime() hands the
+    // bank to the DMA chains at the next frame boundary (at once if stopped).
+    // retime() returns false while the previous switch is still pending.
+    bool retime(int planes, int dwell_us);
+    void commit_retime();
+    bool retime_pending() const { return switch_pending; }
+    // Frame period the programs take with the current planes and dwell: each
+    // row is shifted while the previous one is lit
+    uint32_t frame_us() const;
+
+    // Host stand-in for the PIO/DMA layer: replays one full frame exactly as
+    // the two state machines would drive the pins. sink receives the HUB75 pin
+    // state (GPIO bit positions) and how many row-SM cycles it was held for.
+    typedef void (*PinSink)(uint32_t gpio_state, uint32_t cycles, void *ctx);
+    void emulate_frame(PinSink sink, void *ctx) const;
+
+    // Column bytes per bank, plane-major in the order the DMA streams them
+    alignas(4) uint8_t plane_data[2][MAX_PLANES][SCAN_ROWS][WIDTH];
+    // Row SM words: low ADDR_PINS bits row address, the rest OE-low cycles minus one
+    uint32_t row_ctrl[2][MAX_PLANES][SCAN_ROWS];
+
+private:
+    static constexpr uint32_t DATA_GPIO_MASK = 0x3Fu << DATA_BASE;
+    static constexpr uint32_t ADDR_GPIO_MASK = ((1u << ADDR_PINS) - 1) << ADDR_BASE;
+    static constexpr uint32_t CLK_GPIO_MASK = 1u << PIN_CLK;
+    static constexpr uint32_t LAT_GPIO_MASK = 1u << PIN_LAT;
+    static constexpr uint32_t OE_GPIO_MASK  = 1u << PIN_OE;
+
+    int num_planes;
+    int dwell;        // plane-0 on-time in us
+    uint32_t sys_mhz; // sys_clk the dwell cycles were computed for
+    uint32_t cycles_per_us; // row SM cycles per us of dwell
+    bool active;
+
+    int bank;                    // bank pack() writes
+    int shown;                   // bank the DMA chains stream
+    uint8_t bank_planes[2];
+    volatile bool switch_pending; // shown becomes bank at the next frame start
+
+    // Hardware handles (unused by the host stand-in)
+    int data_sm, row_sm;
+    int data_offset, row_offset;
+    int data_chan, data_ctrl_chan, row_chan, row_ctrl_chan;
+    // Read-address words the control channels write back into the data channels
+    const void *data_start;
+    const void *row_start;
+
+    void build_row_ctrl(int dwell_cycles_per_unit);
+    void switch_banks();
+    static Hub75PioEngine *irq_owner; // engine running on the device
+    static void frame_irq();
+};
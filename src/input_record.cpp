@@ -0,0 +1,251 @@
+// input_record.cpp - delta-encoded input ring, dump/load and replay
+
+#include "input_record.h"
+#include <cstring>
+#include <cctype>
+
+enum : uint8_t { REC_JOY, REC_KEY, REC_CHECK, REC_RESTORE };
+static constexpr uint32_t DT_ESCAPE = 63;
+
+// Keyframes only load into a build with the same physics scalar ("j": the
+// joystick state is Q16.16 in both)
+static const char *const FORMAT = BRICK_FIXED_POINT ? "q16j" : "f32j";
+
+static uint32_t put_varint(uint8_t *p, uint32_t v) {
+    uint32_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static uint32_t put_header(uint8_t *p, uint8_t type, uint32_t dt_ms) {
+    if (dt_ms < DT_ESCAPE) {
+        p[0] = (uint8_t)(type | dt_ms << 2);
+        return 1;
+    }
+    p[0] = (uint8_t)(type | DT_ESCAPE << 2);
+    return 1 + put_varint(p + 1, dt_ms);
+}
+
+void input_keyframe(InputKeyframe &k, const BrickBreaker &game, const JoystickPaddle &joy) {
+    memset((void *)&k, 0, sizeof(k));
+    game.save(k.game);
+    k.joy = joy.state;
+}
+
+InputRecorder::InputRecorder() {
+    is_paused = false;
+    clear();
+}
+
+void InputRecorder::clear() {
+    head = tail = 0;
+    key_head = key_tail = 0;
+    last_ms = 0;
+    last_raw = 0;
+    need_restore = false;
+}
+
+bool InputRecorder::keyframe_due() const {
+    if (key_head == key_tail || need_restore) return true;
+    return head - key_pos[(key_head - 1) & (MAX_KEYFRAMES - 1)] >= KEYFRAME_BYTES;
+}
+
+void InputRecorder::keyframe(uint32_t now_ms, const InputKeyframe &k, bool restore) {
+    if (is_paused) return;
+    uint8_t rec[16 + sizeof(InputKeyframe)];
+    uint32_t n = put_header(rec, restore || need_restore ? REC_RESTORE : REC_CHECK, 0);
+    for (int i = 0; i < 4; ++i) rec[n++] = (uint8_t)(now_ms >> (8 * i));
+    rec[n++] = (uint8_t)last_raw;
+    rec[n++] = (uint8_t)(last_raw >> 8);
+    memcpy(rec + n, &k, sizeof(k));
+    n += sizeof(k);
+    write(rec, n, true);
+    last_ms = now_ms;
+    need_restore = false;
+}
+
+void InputRecorder::joystick(uint32_t now_ms, uint16_t raw) {
+    if (is_paused) return;
+    uint8_t rec[16];
+    uint32_t n = put_header(rec, REC_JOY, now_ms - last_ms);
+    int32_t d = (int32_t)raw - (int32_t)last_raw;
+    n += put_varint(rec + n, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+    write(rec, n, false);
+    last_ms = now_ms;
+    last_raw = raw;
+}
+
+void InputRecorder::key(uint32_t now_ms, char k) {
+    if (is_paused) return;
+    uint8_t rec[8];
+    uint32_t n = put_header(rec, REC_KEY, now_ms - last_ms);
+    rec[n++] = (uint8_t)k;
+    write(rec, n, false);
+    last_ms = now_ms;
+}
+
+void InputRecorder::set_paused(bool on) {
+    is_paused = on;
+    if (!on) need_restore = true;
+}
+
+void InputRecorder::drop_oldest() {
+    key_tail++;
+    tail = key_head == key_tail ? head : key_pos[key_tail & (MAX_KEYFRAMES - 1)];
+}
+
+void InputRecorder::write(const uint8_t *rec, uint32_t len, bool is_keyframe) {
+    // a delta with no keyframe before it can't be replayed
+    if (!is_keyframe && key_head == key_tail) return;
+    if (is_keyframe && key_head - key_tail == MAX_KEYFRAMES) drop_oldest();
+    while (head + len - tail > RING_SIZE) {
+        drop_oldest();
+        if (!is_keyframe && key_head == key_tail) return;
+    }
+    if (is_keyframe) key_pos[key_head++ & (MAX_KEYFRAMES - 1)] = head;
+    for (uint32_t i = 0; i < len; ++i) ring[(head + i) & (RING_SIZE - 1)] = rec[i];
+    head += len;
+}
+
+void InputRecorder::dump() const {
+    printf("REC %s %u %lu\n", FORMAT, (unsigned)sizeof(InputKeyframe), (unsigned long)size());
+    for (uint32_t p = tail; p != head; ++p) {
+        printf("%02x", ring[p & (RING_SIZE - 1)]);
+        if ((p - tail) % 32 == 31 || p + 1 == head) printf("\n");
+    }
+    printf("END\n");
+}
+
+InputReplay InputRecorder::replay() const {
+    return InputReplay(ring, RING_SIZE, tail & (RING_SIZE - 1), head - tail);
+}
+
+InputReplay::InputReplay(const uint8_t *buf, uint32_t cap, uint32_t start, uint32_t len)
+    : buf(buf), cap(cap), start(start), len(len), pos(0), now_ms(0), raw(0) {
+    memset(&st, 0, sizeof(st));
+}
+
+bool InputReplay::get(uint8_t &b) {
+    if (pos >= len) return false;
+    b = buf[(start + pos) % cap];
+    pos++;
+    return true;
+}
+
+bool InputReplay::get_varint(uint32_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b;
+        if (!get(b)) return false;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool InputReplay::get_keyframe(InputKeyframe &k) {
+    uint8_t b[6];
+    for (uint8_t &x : b) {
+        if (!get(x)) return false;
+    }
+    now_ms = (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+    raw = (uint16_t)(b[4] | b[5] << 8);
+    uint8_t *dst = (uint8_t *)&k;
+    for (uint32_t i = 0; i < sizeof(k); ++i) {
+        if (!get(dst[i])) return false;
+    }
+    return true;
+}
+
+bool InputReplay::begin(BrickBreaker &game, JoystickPaddle &joy) {
+    pos = 0;
+    memset(&st, 0, sizeof(st));
+    uint8_t h;
+    uint32_t dt = 0;
+    InputKeyframe k;
+    if (!get(h) || (h & 3) < REC_CHECK) return false;
+    if ((h >> 2) == DT_ESCAPE && !get_varint(dt)) return false;
+    if (!get_keyframe(k)) return false;
+    game.restore(k.game);
+    joy.state = k.joy;
+    st.first_ms = st.last_ms = now_ms;
+    return true;
+}
+
+bool InputReplay::next_tick(BrickBreaker &game, JoystickPaddle &joy, uint16_t &out, KeyFn key_fn, void *ctx) {
+    while (true) {
+        uint8_t h;
+        if (!get(h)) return false;
+        uint32_t dt = h >> 2;
+        if (dt == DT_ESCAPE && !get_varint(dt)) return false;
+        uint8_t type = h & 3;
+        if (type == REC_JOY) {
+            uint32_t z;
+            if (!get_varint(z)) return false;
+            raw = (uint16_t)(raw + (int32_t)((z >> 1) ^ (0u - (z & 1))));
+            now_ms += dt;
+            st.last_ms = now_ms;
+            st.ticks++;
+            out = raw;
+            return true;
+        }
+        if (type == REC_KEY) {
+            uint8_t k;
+            if (!get(k)) return false;
+            now_ms += dt;
+            st.last_ms = now_ms;
+            st.keys++;
+            KeyResult r = game_key(game, (char)k);
+            if (key_fn) key_fn((char)k, r, ctx);
+            continue;
+        }
+        InputKeyframe k;
+        if (!get_keyframe(k)) return false;
+        st.last_ms = now_ms;
+        bool reload = type == REC_RESTORE;
+        if (type == REC_CHECK) {
+            InputKeyframe cur;
+            input_keyframe(cur, game, joy);
+            st.keyframes++;
+            if (memcmp(&cur, &k, sizeof(k)) != 0) {
+                st.diverged++;
+                reload = true;
+            }
+        }
+        if (reload) {
+            game.restore(k.game);
+            joy.state = k.joy;
+        }
+    }
+}
+
+static int hex_digit(char c) {
+    return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+uint32_t input_load_dump(FILE *f, uint8_t *out, uint32_t cap) {
+    char line[256];
+    bool in = false;
+    unsigned long expect = 0;
+    uint32_t n = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (!in) {
+            const char *rec = strstr(line, "REC ");
+            char fmt[8];
+            unsigned size;
+            if (!rec || sscanf(rec, "REC %7s %u %lu", fmt, &size, &expect) != 3) continue;
+            if (strcmp(fmt, FORMAT) != 0 || size != sizeof(InputKeyframe) || expect > cap) return 0;
+            in = true;
+            continue;
+        }
+        if (strncmp(line, "END", 3) == 0) break;
+        for (const char *p = line; isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1]) && n < cap; p += 2) {
+            out[n++] = (uint8_t)(hex_digit(p[0]) << 4 | hex_digit(p[1]));
+        }
+    }
+    return in && n == expect ? n : 0;
+}
@@ -0,0 +1,123 @@
+// input_record.h - compact recording of the game's inputs, and its replay
+//
+// InputRecorder logs, in order, the joystick reading behind every physics
+// tick and every keypad press the game acts on, into a byte ring:
+//   header byte  bits 0-1 record type, bits 2-7 ms since the previous record
+//                (63: a varint with the ms follows)
+//   JOY          zigzag varint of the change from the previous reading
+//   KEY          the key
+//   keyframe     absolute ms (4 bytes), last reading (2 bytes), InputKeyframe
+// A steady joystick costs two bytes per tick. A keyframe goes in at least
+// every KEYFRAME_BYTES; when the ring is full the oldest keyframe and what
+// follows it up to the next one are dropped, so the data kept always starts
+// from a known state. dump() prints it over stdio as hex.
+//
+// InputReplay restores the first keyframe and then hands back the readings
+// one physics tick at a time, applying keys on the way. Later keyframes are
+// compared with the replayed state: a mismatch is counted and the recorded
+// state restored, so one divergence doesn't hide the next.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include "game_input.h"
+
+// Keyframe payload: everything game_tick() and game_key() depend on
+struct InputKeyframe {
+    GameSnapshot game;
+    JoystickPaddle::State joy;
+};
+
+void input_keyframe(InputKeyframe &k, const BrickBreaker &game, const JoystickPaddle &joy);
+
+class InputReplay;
+
+class InputRecorder {
+public:
+    static constexpr int RING_BITS = 14;                 // 16 KB, ~5 min of play
+    static constexpr uint32_t RING_SIZE = 1u << RING_BITS;
+    static constexpr uint32_t KEYFRAME_BYTES = 1024;
+    static constexpr int MAX_KEYFRAMES = 32;             // power of two
+
+    InputRecorder();
+
+    // True when the next record has to be preceded by keyframe()
+    bool keyframe_due() const;
+    // restore: the state was set rather than played into (a replay ran,
+    // the game was reloaded), so replay restores it instead of checking it
+    void keyframe(uint32_t now_ms, const InputKeyframe &k, bool restore = false);
+    void joystick(uint32_t now_ms, uint16_t raw);
+    void key(uint32_t now_ms, char k);
+
+    // While paused records are dropped; the first keyframe after resuming
+    // is a restore one
+    void set_paused(bool on);
+    bool paused() const { return is_paused; }
+
+    // Bytes held, from the oldest keyframe
+    uint32_t size() const { return head - tail; }
+    void clear();
+
+    // "REC <format> <bytes>", hex lines of 32 bytes, "END"
+    void dump() const;
+    // Replay of what is held; valid until the next record
+    InputReplay replay() const;
+
+private:
+    uint8_t ring[RING_SIZE];
+    uint32_t head, tail;      // bytes written in total / start of the oldest keyframe kept
+    uint32_t key_pos[MAX_KEYFRAMES];
+    uint32_t key_head, key_tail;
+    uint32_t last_ms;         // time of the previous record
+    uint16_t last_raw;        // reading JOY deltas are against
+    bool need_restore;
+    bool is_paused;
+
+    void write(const uint8_t *rec, uint32_t len, bool is_keyframe);
+    void drop_oldest();
+};
+
+class InputReplay {
+public:
+    struct Stats {
+        uint32_t ticks;
+        uint32_t keys;
+        uint32_t keyframes;  // checked against the replayed state
+        uint32_t diverged;   // of which didn't match
+        uint32_t first_ms, last_ms;
+    };
+
+    // Called for each key applied, with what game_key() made of it
+    typedef void (*KeyFn)(char k, const KeyResult &r, void *ctx);
+
+    // len bytes starting at buf[start], wrapping at cap
+    InputReplay(const uint8_t *buf, uint32_t cap, uint32_t start, uint32_t len);
+    InputReplay() : InputReplay(nullptr, 1, 0, 0) {}
+
+    // Restore the first keyframe; false if the data doesn't start with one
+    bool begin(BrickBreaker &game, JoystickPaddle &joy);
+    // Apply keys and check keyframes up to the next physics tick and return
+    // its reading; false at the end of the data (or at a damaged record)
+    bool next_tick(BrickBreaker &game, JoystickPaddle &joy, uint16_t &raw, KeyFn key_fn = nullptr,
+                   void *ctx = nullptr);
+
+    const Stats &stats() const { return st; }
+
+private:
+    const uint8_t *buf;
+    uint32_t cap, start, len;
+    uint32_t pos;
+    uint32_t now_ms;
+    uint16_t raw;
+    Stats st;
+
+    bool get(uint8_t &b);
+    bool get_varint(uint32_t &v);
+    bool get_keyframe(InputKeyframe &k);
+};
+
+// Read the bytes of the first dump in f (a captured serial log) into out.
+// Returns the byte count, 0 if there is none or it was made by a build with
+// a different state layout.
+uint32_t input_load_dump(FILE *f, uint8_t *out, uint32_t cap);
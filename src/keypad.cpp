@@ -0,0 +1,140 @@
+// keypad.cpp - timer-driven keypad scan, debounce and edge queue
+
+#include "keypad.h"
+#include "profiler.h"
+#include <cstring>
+
+#ifndef HOST_BUILD
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#endif
+
+// Keypad GPIO mapping - UPDATE these to match your wiring
+// Columns: outputs; Rows: inputs
+static const uint8_t KEYPAD_COLS[4] = {2, 3, 4, 5};
+static const uint8_t KEYPAD_ROWS[4] = {6, 7, 8, 9};
+
+// Keymap matching the attached schematic:
+// Row0: 1 2 3 A
+// Row1: 4 5 6 B
+// Row2: 7 8 9 C
+// Row3: * 0 # D
+static const char KEYPAD_MAP[4][4] = {
+    { '1', '2', '3', 'A' },
+    { '4', '5', '6', 'B' },
+    { '7', '8', '9', 'C' },
+    { '*', '0', '#', 'D' }
+};
+
+static constexpr uint8_t DEBOUNCE_MASK = (1u << KeypadScanner::DEBOUNCE_SWEEPS) - 1;
+
+KeypadScanner::KeypadScanner() {
+    raw = 0;
+    memset(history, 0, sizeof(history));
+    stable = 0;
+    active_col = 0;
+}
+
+char KeypadScanner::key_at(int row, int col) {
+    return KEYPAD_MAP[row][col];
+}
+
+void KeypadScanner::feed_column(int col, uint8_t rows_pressed, uint32_t now_us) {
+    for (int r = 0; r < ROWS; ++r) {
+        uint16_t bit = (uint16_t)(1u << (r * COLS + col));
+        if (rows_pressed & (1u << r)) raw |= bit; else raw &= (uint16_t)~bit;
+    }
+    if (col == COLS - 1) process_sweep(now_us);
+}
+
+// Without diodes, three pressed corners of a rectangle make the fourth read
+// as pressed too; a key that isn't down yet is ignored while that's the case
+bool KeypadScanner::ghosted(uint16_t pressed, int row, int col) const {
+    for (int r2 = 0; r2 < ROWS; ++r2) {
+        if (r2 == row) continue;
+        for (int c2 = 0; c2 < COLS; ++c2) {
+            if (c2 == col) continue;
+            uint16_t corners = (uint16_t)((1u << (row * COLS + c2)) | (1u << (r2 * COLS + col)) |
+                                          (1u << (r2 * COLS + c2)));
+            if ((pressed & corners) == corners) return true;
+        }
+    }
+    return false;
+}
+
+void KeypadScanner::process_sweep(uint32_t now_us) {
+    uint16_t sample = raw;
+    uint16_t st = stable;
+    for (int k = 0; k < ROWS * COLS; ++k) {
+        bool s = (sample >> k) & 1u;
+        bool down = (st >> k) & 1u;
+        if (s && !down && ghosted(sample, k / COLS, k % COLS)) s = false;
+        history[k] = (uint8_t)((history[k] << 1) | (s ? 1u : 0u));
+
+        uint8_t h = history[k] & DEBOUNCE_MASK;
+        if (!down && h == DEBOUNCE_MASK) {
+            st |= (uint16_t)(1u << k);
+            events.push({ KEYPAD_MAP[k / COLS][k % COLS], true, now_us });
+        } else if (down && h == 0) {
+            st &= (uint16_t)~(1u << k);
+            events.push({ KEYPAD_MAP[k / COLS][k % COLS], false, now_us });
+        }
+    }
+    stable = st;
+}
+
+#ifndef HOST_BUILD
+
+static KeypadScanner *scanner_owner = nullptr;
+static repeating_timer scan_timer;
+
+bool KeypadScanner::begin() {
+    if (scanner_owner) return false;
+    for (int c = 0; c < COLS; ++c) {
+        gpio_init(KEYPAD_COLS[c]);
+        gpio_set_dir(KEYPAD_COLS[c], GPIO_OUT);
+        gpio_put(KEYPAD_COLS[c], 1);
+    }
+    for (int r = 0; r < ROWS; ++r) {
+        gpio_init(KEYPAD_ROWS[r]);
+        gpio_set_dir(KEYPAD_ROWS[r], GPIO_IN);
+        gpio_pull_up(KEYPAD_ROWS[r]);
+    }
+    // drive the first column; it is sampled on the first tick
+    active_col = 0;
+    gpio_put(KEYPAD_COLS[0], 0);
+    scanner_owner = this;
+    // negative period: fixed rate between callback starts
+    return add_repeating_timer_us(-(int64_t)SCAN_PERIOD_US, timer_cb, nullptr, &scan_timer);
+}
+
+bool KeypadScanner::timer_cb(repeating_timer *t) {
+    (void)t;
+    scanner_owner->tick();
+    return true;
+}
+
+void KeypadScanner::tick() {
+    PROFILE_SCOPE(PROF_KEYPAD);
+    // the active column has been low for a whole tick, so the rows have settled
+    uint8_t rows = 0;
+    for (int r = 0; r < ROWS; ++r) {
+        // rows use pull-ups, so pressed will read 0 when column is low
+        if (gpio_get(KEYPAD_ROWS[r]) == 0) rows |= (uint8_t)(1u << r);
+    }
+    int col = active_col;
+    gpio_put(KEYPAD_COLS[col], 1);
+    active_col = (col + 1) % COLS;
+    gpio_put(KEYPAD_COLS[active_col], 0);
+    feed_column(col, rows, time_us_32());
+}
+
+#else
+
+// Host: no hardware; tests/keypad_test.cpp drives feed_column() from a
+// simulated matrix
+bool KeypadScanner::begin() {
+    return true;
+}
+
+#endif
@@ -0,0 +1,65 @@
+// keypad.h - background 4x4 keypad scanner with debounce and an event queue
+//
+// A repeating timer IRQ drives one column low per tick and samples the rows on
+// the next tick, so no time is spent waiting for lines to settle. After each
+// full sweep every key's history is debounced, ghost keys (the fourth corner of
+// a pressed rectangle) are suppressed, and press/release edges are queued with
+// a timestamp. The main loop drains the queue with pop(); nothing blocks.
+//
+// feed_column() is the whole state machine and has no hardware dependencies,
+// so a simulated key matrix can drive it on the host.
+
+#pragma once
+
+#include <cstdint>
+#include "spsc_queue.h"
+
+struct KeyEvent {
+    char key;
+    bool pressed;     // false = released
+    uint32_t time_us; // end of the sweep that confirmed the edge
+};
+
+class KeypadScanner {
+public:
+    static constexpr int ROWS = 4;
+    static constexpr int COLS = 4;
+    static constexpr uint32_t SCAN_PERIOD_US = 1000; // one column per tick
+    static constexpr int DEBOUNCE_SWEEPS = 5;        // ~20 ms at 4 columns/sweep
+    static constexpr int QUEUE_SIZE = 16;            // power of two
+
+    KeypadScanner();
+
+    // Configure pins and start scanning from a repeating timer (device only)
+    bool begin();
+
+    // Next queued edge, or false if none
+    bool pop(KeyEvent &ev) { return events.pop(ev); }
+
+    // Debounced state of a key position
+    bool is_down(int row, int col) const { return (stable >> (row * COLS + col)) & 1u; }
+
+    // Edges lost because the queue was full
+    uint32_t dropped() const { return events.dropped(); }
+
+    // Feed the rows read while column 'col' was driven (bit r = row r pressed).
+    // The sweep is processed once the last column has been fed.
+    void feed_column(int col, uint8_t rows_pressed, uint32_t now_us);
+
+    static char key_at(int row, int col);
+
+private:
+    uint16_t raw;                       // pressed bits of the sweep in progress
+    uint8_t history[ROWS * COLS];       // last samples per key, bit 0 newest
+    volatile uint16_t stable;           // debounced pressed bits
+
+    SpscQueue<KeyEvent, QUEUE_SIZE> events; // pushed by the IRQ, popped by main
+
+    int active_col;
+
+    void process_sweep(uint32_t now_us);
+    bool ghosted(uint16_t pressed, int row, int col) const;
+
+    static bool timer_cb(struct repeating_timer *t);
+    void tick();
+};
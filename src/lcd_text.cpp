@@ -0,0 +1,23 @@
+// lcd_text.cpp - LCD line formats
+//
+// Both lines are exactly 16 columns at their widest, so nothing may run
+// past its field: out-of-range numbers are capped, and a score too big for
+// its field drops the label instead of its last digits.
+
+#include "lcd_text.h"
+#include <cstdio>
+
+static int clamp(int v, int lo, int hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+void lcd_format_score(char *buf, size_t size, int score, int level) {
+    level = clamp(level, 0, 99);
+    score = score < 0 ? 0 : score;
+    if (score <= 99999) snprintf(buf, size, "Lv%02d Score:%5d", level, score);
+    else snprintf(buf, size, "Lv%02d %11d", level, score);
+}
+
+void lcd_format_status(char *buf, size_t size, int lives, const char *difficulty, int fps) {
+    snprintf(buf, size, "L%d %-6.6s%4dfps", clamp(lives, 0, 9), difficulty, clamp(fps, 0, 9999));
+}
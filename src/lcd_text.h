@@ -0,0 +1,14 @@
+// lcd_text.h - the two 16-character LCD lines, formatted for both back ends
+//
+// score.cpp (SPI LCD) and hal_host.cpp (host stand-in) both format through
+// these, so the host shows exactly what the device would.
+
+#pragma once
+
+#include <cstddef>
+
+// Line 0: level and score; "Score:" is dropped above 99999 to fit
+void lcd_format_score(char *buf, size_t size, int score, int level);
+// Line 1: lives, difficulty name and frames per second, capped at 9, six
+// characters and 9999
+void lcd_format_status(char *buf, size_t size, int lives, const char *difficulty, int fps);
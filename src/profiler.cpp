@@ -0,0 +1,101 @@
+// profiler.cpp - stage histograms and the stdio report
+
+#include "profiler.h"
+
+#if BRICK_PROFILE
+
+#include <cstdio>
+#include <cstring>
+#ifndef HOST_BUILD
+#include "hardware/clocks.h"
+#endif
+
+// Bucket 0..3 = 0..3 cycles, then 4 buckets per power of two up to 2^32
+static constexpr int HIST_BUCKETS = 124;
+
+struct StageStats {
+    uint32_t n;
+    uint32_t min, max;
+    uint64_t total;
+    uint32_t hist[HIST_BUCKETS];
+};
+
+static StageStats stages[PROF_STAGES];
+
+static const char *const STAGE_NAMES[PROF_STAGES] = {
+    "render", "refresh", "keypad", "adc", "physics", "events", "lcd", "audio",
+};
+
+static int bucket_of(uint32_t v) {
+    if (v < 4) return (int)v;
+    int msb = 31 - __builtin_clz(v);
+    return (msb - 1) * 4 + (int)((v >> (msb - 2)) & 3);
+}
+
+// Smallest value that lands in bucket b
+static uint32_t bucket_floor(int b) {
+    if (b < 4) return (uint32_t)b;
+    int msb = b / 4 + 1;
+    return (uint32_t)(4 + (b & 3)) << (msb - 2);
+}
+
+void profiler_init() {
+#if defined(HOST_BUILD)
+#elif PICO_RP2350
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_cyccnt = 0;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+#else
+    systick_hw->rvr = PROFILE_CYCLE_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // enable, processor clock
+#endif
+    profiler_reset();
+}
+
+void profiler_reset() {
+    memset(stages, 0, sizeof(stages));
+    for (int s = 0; s < PROF_STAGES; ++s) stages[s].min = 0xFFFFFFFFu;
+}
+
+void profiler_record(ProfStage s, uint32_t cycles) {
+    StageStats &st = stages[s];
+    st.n++;
+    st.total += cycles;
+    if (cycles < st.min) st.min = cycles;
+    if (cycles > st.max) st.max = cycles;
+    st.hist[bucket_of(cycles)]++;
+}
+
+// Cycles to tenths of a microsecond
+static unsigned long tenths_us(uint64_t cycles, uint32_t mhz) {
+    return (unsigned long)(cycles * 10 / mhz);
+}
+
+void profiler_report() {
+#ifdef HOST_BUILD
+    uint32_t mhz = 1000; // nanosecond counter
+#else
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+#endif
+    printf("stage         n     min     avg     p99     max  (us)\n");
+    for (int s = 0; s < PROF_STAGES; ++s) {
+        const StageStats &st = stages[s];
+        if (!st.n) continue;
+        // upper edge of the bucket holding the 99th percentile sample
+        uint32_t rank = st.n - st.n / 100;
+        uint32_t seen = 0;
+        int b = 0;
+        while (b < HIST_BUCKETS - 1 && (seen += st.hist[b]) < rank) ++b;
+        uint64_t p99 = b + 1 < HIST_BUCKETS ? bucket_floor(b + 1) : 0xFFFFFFFFu;
+        if (p99 > st.max) p99 = st.max;
+        unsigned long v[4] = { tenths_us(st.min, mhz), tenths_us(st.total / st.n, mhz),
+                               tenths_us(p99, mhz), tenths_us(st.max, mhz) };
+        printf("%-8s %6lu", STAGE_NAMES[s], (unsigned long)st.n);
+        for (unsigned long x : v) printf(" %5lu.%lu", x / 10, x % 10);
+        printf("\n");
+    }
+    profiler_reset();
+}
+
+#endif
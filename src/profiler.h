@@ -0,0 +1,78 @@
+// profiler.h - per-stage cycle timing with histograms, reported over stdio
+//
+// PROFILE_SCOPE(PROF_x) times the rest of the enclosing block in CPU cycles
+// (DWT cycle counter on RP2350, SysTick on RP2040, nanoseconds on the host)
+// and adds it to the stage's histogram: four log-linear buckets per power of
+// two in fixed RAM, so p99 is within one bucket (~19%). With BRICK_PROFILE=0
+// (the default) the scopes and calls compile to nothing.
+
+#pragma once
+
+#include <cstdint>
+
+// Override with -DBRICK_PROFILE=1 in build flags
+#ifndef BRICK_PROFILE
+#define BRICK_PROFILE 0
+#endif
+
+enum ProfStage : uint8_t {
+    PROF_RENDER,   // BrickBreaker::render
+    PROF_REFRESH,  // Hub75Matrix::refresh_once (repack + scan out / hand-over)
+    PROF_KEYPAD,   // keypad scan tick (timer IRQ)
+    PROF_ADC,      // joystick read
+    PROF_PHYSICS,  // BrickBreaker::update_physics
+    PROF_EVENTS,   // game events -> sfx / lcd_print_score
+    PROF_LCD,      // lcd_update
+    PROF_AUDIO,    // mixing one audio buffer (DMA IRQ)
+    PROF_STAGES
+};
+
+#if BRICK_PROFILE
+
+#if defined(HOST_BUILD)
+#include <chrono>
+static constexpr uint32_t PROFILE_CYCLE_MASK = 0xFFFFFFFFu;
+inline uint32_t profiler_cycles() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#elif PICO_RP2350
+#include "hardware/structs/m33.h"
+static constexpr uint32_t PROFILE_CYCLE_MASK = 0xFFFFFFFFu;
+inline uint32_t profiler_cycles() { return m33_hw->dwt_cyccnt; }
+#else
+#include "hardware/structs/systick.h"
+// SysTick is a 24-bit down-counter
+static constexpr uint32_t PROFILE_CYCLE_MASK = 0x00FFFFFFu;
+inline uint32_t profiler_cycles() { return PROFILE_CYCLE_MASK - systick_hw->cvr; }
+#endif
+
+// Start the cycle counter; call once at boot
+void profiler_init();
+void profiler_record(ProfStage s, uint32_t cycles);
+// Print n/min/avg/p99/max per stage in microseconds, then start over
+void profiler_report();
+void profiler_reset();
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfStage s) : stage(s), start(profiler_cycles()) {}
+    ~ProfileScope() { profiler_record(stage, (profiler_cycles() - start) & PROFILE_CYCLE_MASK); }
+
+private:
+    ProfStage stage;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(stage)
+
+#else
+
+inline void profiler_init() {}
+inline void profiler_report() {}
+inline void profiler_reset() {}
+#define PROFILE_SCOPE(stage) ((void)0)
+
+#endif
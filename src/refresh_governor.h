@@ -0,0 +1,84 @@
+// refresh_governor.h - picks the HUB75 bit-plane count and dwell at runtime
+//
+// A frame of N planes with plane-0 dwell D costs roughly
+//     N * rows * o  +  rows * D * (2^N - 1)
+// where o is the per-row shift/latch/loop overhead. The governor averages the
+// measured frame period over a window, solves for o, and then moves one step:
+// down (dwell first, then planes) when the refresh rate is under target, up
+// (planes first, then dwell back to its ceiling) when the model says the next
+// step still clears the target with some margin. No Pico dependencies.
+
+#pragma once
+
+#include <cstdint>
+
+class RefreshGovernor {
+public:
+    static constexpr int WINDOW = 16;      // frames averaged per decision
+    static constexpr int MARGIN_PCT = 15;  // headroom needed before stepping up
+    static constexpr int MIN_DWELL_US = 1;
+
+    struct Setting {
+        int planes;
+        int dwell_us;
+    };
+
+    RefreshGovernor(int scan_rows, int min_planes, int max_planes, Setting start)
+        : rows(scan_rows), min_planes(min_planes), max_planes(max_planes), max_dwell(start.dwell_us),
+          cur(start), target(0), sum_us(0), count(0), avg_us(0) {}
+
+    // Minimum refresh rate to hold; 0 turns the governor off
+    void set_target_hz(uint32_t hz) { target = hz; count = 0; sum_us = 0; }
+    uint32_t target_hz() const { return target; }
+
+    Setting setting() const { return cur; }
+    // Average over the last complete window (0 until there is one)
+    uint32_t measured_hz() const { return avg_us ? 1000000u / avg_us : 0; }
+
+    // Feed one measured frame period; true when the setting changed
+    bool sample(uint32_t period_us) {
+        if (!target) return false;
+        sum_us += period_us;
+        if (++count < WINDOW) return false;
+        avg_us = (uint32_t)(sum_us / WINDOW);
+        sum_us = 0;
+        count = 0;
+
+        // per-row overhead implied by the measurement (loop work included)
+        int64_t lit = lit_us(cur);
+        int64_t o = ((int64_t)avg_us - lit) / ((int64_t)cur.planes * rows);
+        if (o < 0) o = 0;
+
+        uint32_t budget = 1000000u / target;
+        Setting next = cur;
+        if (avg_us > budget) {
+            if (cur.dwell_us > MIN_DWELL_US) next.dwell_us--;
+            else if (cur.planes > min_planes) next.planes--;
+        } else {
+            Setting more_planes = { cur.planes + 1, cur.dwell_us };
+            Setting more_dwell = { cur.planes, cur.dwell_us + 1 };
+            if (cur.planes < max_planes && fits(more_planes, o, budget)) next = more_planes;
+            else if (cur.dwell_us < max_dwell && fits(more_dwell, o, budget)) next = more_dwell;
+        }
+        if (next.planes == cur.planes && next.dwell_us == cur.dwell_us) return false;
+        cur = next;
+        return true;
+    }
+
+private:
+    int rows;
+    int min_planes, max_planes;
+    int max_dwell;
+    Setting cur;
+    uint32_t target;
+    uint64_t sum_us;
+    int count;
+    uint32_t avg_us;
+
+    int64_t lit_us(Setting s) const { return (int64_t)rows * s.dwell_us * ((1 << s.planes) - 1); }
+
+    bool fits(Setting s, int64_t o, uint32_t budget) const {
+        int64_t predicted = (int64_t)s.planes * rows * o + lit_us(s);
+        return predicted * (100 + MARGIN_PCT) <= (int64_t)budget * 100;
+    }
+};
@@ -0,0 +1,84 @@
+// scheduler.cpp - EDF task scheduler
+
+#include "scheduler.h"
+#include "hal.h"
+#include <cstdio>
+
+TaskScheduler::TaskScheduler() {
+    n_tasks = 0;
+}
+
+int TaskScheduler::add_task(const char *name, TaskFn fn, void *ctx, uint32_t period_us, int priority, uint32_t budget_us) {
+    if (n_tasks >= MAX_TASKS) return -1;
+    Task &t = tasks[n_tasks];
+    t.name = name;
+    t.fn = fn;
+    t.ctx = ctx;
+    t.period_us = period_us;
+    t.budget_us = budget_us;
+    t.priority = priority;
+    t.release_us = hal_time_us_64();
+    t.runs = t.overruns = t.misses = t.max_us = 0;
+    t.total_us = 0;
+    return n_tasks++;
+}
+
+bool TaskScheduler::run_once() {
+    uint64_t now = hal_time_us_64();
+    int best = -1;
+    uint64_t best_deadline = 0;
+    for (int i = 0; i < n_tasks; ++i) {
+        const Task &t = tasks[i];
+        if (t.release_us > now) continue;
+        uint64_t deadline = t.release_us + t.period_us;
+        if (best < 0 || deadline < best_deadline ||
+            (deadline == best_deadline && t.priority < tasks[best].priority)) {
+            best = i;
+            best_deadline = deadline;
+        }
+    }
+    if (best < 0) return false;
+
+    Task &t = tasks[best];
+    uint64_t start = hal_time_us_64();
+    t.fn(t.ctx);
+    uint64_t end = hal_time_us_64();
+
+    uint32_t took = (uint32_t)(end - start);
+    t.runs++;
+    t.total_us += took;
+    if (took > t.max_us) t.max_us = took;
+    if (took > t.budget_us) t.overruns++;
+    if (end > best_deadline) t.misses++;
+
+    // next release; if we fell more than a period behind, drop the backlog
+    // instead of running the task back to back to catch up
+    t.release_us += t.period_us;
+    if (t.release_us + t.period_us < end) t.release_us = end;
+    return true;
+}
+
+void TaskScheduler::run() {
+    while (true) {
+        if (!run_once()) hal_idle();
+    }
+}
+
+void TaskScheduler::print_stats() const {
+    printf("task       period  budget   runs   avg   max  over  miss\n");
+    for (int i = 0; i < n_tasks; ++i) {
+        const Task &t = tasks[i];
+        unsigned long avg = t.runs ? (unsigned long)(t.total_us / t.runs) : 0;
+        printf("%-9s %7lu %7lu %6lu %5lu %5lu %5lu %5lu\n", t.name,
+               (unsigned long)t.period_us, (unsigned long)t.budget_us, (unsigned long)t.runs,
+               avg, (unsigned long)t.max_us, (unsigned long)t.overruns, (unsigned long)t.misses);
+    }
+}
+
+void TaskScheduler::reset_stats() {
+    for (int i = 0; i < n_tasks; ++i) {
+        Task &t = tasks[i];
+        t.runs = t.overruns = t.misses = t.max_us = 0;
+        t.total_us = 0;
+    }
+}
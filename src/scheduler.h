@@ -0,0 +1,52 @@
+// scheduler.h - cooperative earliest-deadline-first scheduler for the main loop
+//
+// Each task is released once per period and must finish before the next
+// release (its deadline). run_once() runs the released task with the earliest
+// deadline, ties going to the lower priority number, and records how long it
+// took against its budget.
+
+#pragma once
+
+#include <cstdint>
+
+class TaskScheduler {
+public:
+    typedef void (*TaskFn)(void *ctx);
+
+    static constexpr int MAX_TASKS = 8;
+
+    struct Task {
+        const char *name;
+        TaskFn fn;
+        void *ctx;
+        uint32_t period_us;
+        uint32_t budget_us;   // expected worst-case run time
+        int priority;         // tie-break between equal deadlines, lower first
+        uint64_t release_us;  // next release; deadline is release + period
+        // stats since the last reset_stats()
+        uint32_t runs;
+        uint32_t overruns;    // ran longer than budget_us
+        uint32_t misses;      // finished after the deadline
+        uint32_t max_us;
+        uint64_t total_us;
+    };
+
+    TaskScheduler();
+
+    // Returns the task id, or -1 if the table is full
+    int add_task(const char *name, TaskFn fn, void *ctx, uint32_t period_us, int priority, uint32_t budget_us);
+
+    // Run the most urgent released task; returns false if none was ready
+    bool run_once();
+    // Run tasks forever
+    void run();
+
+    int task_count() const { return n_tasks; }
+    const Task &task(int id) const { return tasks[id]; }
+    void print_stats() const;
+    void reset_stats();
+
+private:
+    Task tasks[MAX_TASKS];
+    int n_tasks;
+};
@@ -1,73 +1,192 @@
-// score.cpp -- LCD bitbang and score display
+// score.cpp -- LCD score display over hardware SPI + DMA
+//
+// Nothing here blocks. Byte sequences and the delays the LCD needs after a
+// command are queued as ops; lcd_update() (polled from the main loop) starts
+// the next op once the DMA transfer and any hold-off of the previous one are
+// done.
+//
+// Text goes into a 2x16 target buffer; a shadow copy tracks what the LCD
+// actually shows. Once the queue has drained, lcd_update() diffs the two and
+// queues a cursor command plus only the changed characters for each run of
+// differences, so repeated updates coalesce and a one-digit change costs a
+// few bytes instead of a clear and a full line.
+//
+// Device only; the host build gets the LCD from hal_host.cpp.
 
-#include "pico/stdlib.h"
-#include "hardware/gpio.h"
-#include <cstdio>
+#ifndef HOST_BUILD
+
+#include "hal.h"
+#include "lcd_text.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
 #include <cstring>
 
-// Use GPIO pins provided by the user
+// Use GPIO pins provided by the user (SPI0 SCK/TX on these pins)
 static const int LCD_SCK = 34;
 static const int LCD_TX  = 35;
 static const int LCD_CSn = 33;
 
-// Bitbang SPI write (MSB-first)
-static void lcd_write_raw(const char *buf, size_t len) {
-    gpio_put(LCD_CSn, 0);
-    for (size_t i = 0; i < len; ++i) {
-        uint8_t b = (uint8_t)buf[i];
-        // send LSB-first (bit0 .. bit7) which matches UART/serial backpack ordering
-        for (int bit = 0; bit < 8; ++bit) {
-            gpio_put(LCD_TX, (b >> bit) & 1);
-            busy_wait_us_32(3);
-            gpio_put(LCD_SCK, 1);
-            busy_wait_us_32(3);
-            gpio_put(LCD_SCK, 0);
-        }
-    }
-    gpio_put(LCD_CSn, 1);
+#define LCD_SPI spi0
+// Close to the old bit-bang rate (6 us per bit)
+static const uint32_t LCD_BAUD = 150000;
+// Hold-off after a 0xFE command (the old code busy-waited this long)
+static const uint16_t LCD_CMD_DELAY_US = 2000;
+
+// One queued transfer: bytes sent in a single CS assertion, then a pause
+struct LcdOp {
+    uint8_t len;
+    uint8_t bytes[17];
+    uint16_t delay_us;
+};
+
+static const int LCD_QUEUE_SIZE = 8; // power of two
+static LcdOp lcd_queue[LCD_QUEUE_SIZE];
+static uint32_t lcd_head = 0, lcd_tail = 0;
+
+static int lcd_dma = -1;
+static bool lcd_sending = false;       // DMA/SPI transfer in flight
+static uint64_t lcd_hold_until = 0;    // no new op before this time (64-bit: never wraps)
+static uint16_t lcd_pending_delay = 0; // hold-off of the op in flight
+
+static const int LCD_COLS = 16;
+static const int LCD_LINES = 2;
+// DDRAM address of each line (set-cursor command is 0x80 | address)
+static const uint8_t LCD_LINE_ADDR[LCD_LINES] = { 0x00, 0x40 };
+// Unchanged characters shorter than a cursor command are resent instead
+static const int LCD_MERGE_GAP = 2;
+
+static char lcd_target[LCD_LINES][LCD_COLS]; // what we want shown
+static char lcd_shadow[LCD_LINES][LCD_COLS]; // what the LCD shows
+static bool lcd_dirty = false;
+
+// The backpack takes bits LSB-first; the SPI block only shifts MSB-first
+static constexpr uint8_t reverse_bits(uint8_t b) {
+    b = (uint8_t)(((b & 0xF0) >> 4) | ((b & 0x0F) << 4));
+    b = (uint8_t)(((b & 0xCC) >> 2) | ((b & 0x33) << 2));
+    b = (uint8_t)(((b & 0xAA) >> 1) | ((b & 0x55) << 1));
+    return b;
+}
+
+// Returns false if the queue is full
+static bool lcd_queue_write(const char *buf, size_t len, uint16_t delay_us) {
+    if (lcd_head - lcd_tail >= (uint32_t)LCD_QUEUE_SIZE) return false;
+    LcdOp &op = lcd_queue[lcd_head & (LCD_QUEUE_SIZE - 1)];
+    if (len > sizeof(op.bytes)) len = sizeof(op.bytes);
+    for (size_t i = 0; i < len; ++i) op.bytes[i] = reverse_bits((uint8_t)buf[i]);
+    op.len = (uint8_t)len;
+    op.delay_us = delay_us;
+    lcd_head++;
+    return true;
 }
 
 // Many serial LCD backpacks accept 0xFE as a command prefix over serial/SPI
-static void lcd_send_cmd(uint8_t cmd) {
+static bool lcd_queue_cmd(uint8_t cmd, uint16_t delay_us = LCD_CMD_DELAY_US) {
     char seq[2] = { (char)0xFE, (char)cmd };
-    lcd_write_raw(seq, 2);
-    busy_wait_us_32(2000);
+    return lcd_queue_write(seq, 2, delay_us);
+}
+
+// Queue the differences between target and shadow; returns false if the
+// queue filled up (the rest goes out on a later pass)
+static bool lcd_queue_diff() {
+    for (int line = 0; line < LCD_LINES; ++line) {
+        const char *want = lcd_target[line];
+        char *have = lcd_shadow[line];
+        int col = 0;
+        while (col < LCD_COLS) {
+            if (want[col] == have[col]) { col++; continue; }
+            // extend the run over short gaps of matching characters
+            int start = col, end = col + 1, gap = 0;
+            for (int i = end; i < LCD_COLS && gap <= LCD_MERGE_GAP; ++i) {
+                if (want[i] != have[i]) { end = i + 1; gap = 0; } else gap++;
+            }
+            if (LCD_QUEUE_SIZE - (int)(lcd_head - lcd_tail) < 2) return false;
+            lcd_queue_cmd((uint8_t)(0x80 | (LCD_LINE_ADDR[line] + start)));
+            lcd_queue_write(want + start, end - start, 0);
+            memcpy(have + start, want + start, end - start);
+            col = end;
+        }
+    }
+    return true;
+}
+
+// Copy text into a line of the target buffer, padded with spaces
+static void lcd_set_line(int line, const char *text) {
+    size_t slen = strlen(text);
+    if (slen > (size_t)LCD_COLS) slen = LCD_COLS;
+    char *dst = lcd_target[line];
+    memcpy(dst, text, slen);
+    memset(dst + slen, ' ', LCD_COLS - slen);
+    lcd_dirty = true;
 }
 
 void lcd_init_display() {
-    gpio_init(LCD_CSn);
-    gpio_set_dir(LCD_CSn, GPIO_OUT);
-    gpio_put(LCD_CSn, 1);
+    hal_gpio_init_out(LCD_CSn, 1);
+
+    // mode 0 matches the old bit-bang: data set up before the rising edge.
+    // CS stays a plain GPIO so one op is one CS assertion.
+    spi_init(LCD_SPI, LCD_BAUD);
+    spi_set_format(LCD_SPI, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    gpio_set_function(LCD_SCK, GPIO_FUNC_SPI);
+    gpio_set_function(LCD_TX, GPIO_FUNC_SPI);
 
-    gpio_init(LCD_SCK);
-    gpio_set_dir(LCD_SCK, GPIO_OUT);
-    gpio_put(LCD_SCK, 0);
+    lcd_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(lcd_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(LCD_SPI, true));
+    dma_channel_configure(lcd_dma, &c, &spi_get_hw(LCD_SPI)->dr, nullptr, 0, false);
 
-    gpio_init(LCD_TX);
-    gpio_set_dir(LCD_TX, GPIO_OUT);
-    gpio_put(LCD_TX, 0);
+    // start from a known blank screen; after this only diffs are sent
+    memset(lcd_target, ' ', sizeof(lcd_target));
+    memset(lcd_shadow, ' ', sizeof(lcd_shadow));
+    lcd_queue_cmd(0x01, 2 * LCD_CMD_DELAY_US); // clear display
 }
 
 void lcd_print_score(int score, int level) {
     char buf[32];
-    snprintf(buf, sizeof(buf), "Lvl%02d Score:%5d", level, score);
-    // Try clearing display and setting cursor (common serial backpack protocol)
-    lcd_send_cmd(0x01); // clear display
-    busy_wait_us_32(2000);
-
-    // Set DDRAM addr to start of first line (0x80) and write up to 16 chars
-    lcd_send_cmd(0x80);
-    // Ensure exactly 16 chars for first line
-    char line1[17];
-    size_t slen = strlen(buf);
-    if (slen >= 16) {
-        memcpy(line1, buf, 16);
-    } else {
-        memcpy(line1, buf, slen);
-        memset(line1 + slen, ' ', 16 - slen);
+    lcd_format_score(buf, sizeof(buf), score, level);
+    lcd_set_line(0, buf);
+}
+
+void lcd_print_status(int lives, const char *difficulty, int fps) {
+    char buf[32];
+    lcd_format_status(buf, sizeof(buf), lives, difficulty, fps);
+    lcd_set_line(1, buf);
+}
+
+void lcd_update() {
+    if (lcd_dma < 0) return;
+    uint64_t now = hal_time_us_64();
+
+    if (lcd_sending) {
+        // DMA done only means the FIFO has the last byte; wait for the shifter
+        if (dma_channel_is_busy(lcd_dma) || spi_is_busy(LCD_SPI)) return;
+        hal_gpio_put(LCD_CSn, 1);
+        lcd_sending = false;
+        lcd_hold_until = now + lcd_pending_delay;
+        // release the slot only now; the DMA was reading from it
+        lcd_tail++;
     }
-    line1[16] = '\0';
-    lcd_write_raw(line1, 16);
+    if (now < lcd_hold_until) return;
 
-    // (Optional) If you want the second line to show something, set 0xC0 and write there.
+    if (lcd_tail == lcd_head) {
+        if (!lcd_dirty) return;
+        lcd_dirty = !lcd_queue_diff();
+        if (lcd_tail == lcd_head) return;
+    }
+
+    const LcdOp &op = lcd_queue[lcd_tail & (LCD_QUEUE_SIZE - 1)];
+    if (op.len == 0) {
+        lcd_tail++;
+        lcd_hold_until = now + op.delay_us;
+        return;
+    }
+    lcd_pending_delay = op.delay_us;
+    hal_gpio_put(LCD_CSn, 0);
+    dma_channel_set_read_addr(lcd_dma, op.bytes, false);
+    dma_channel_set_trans_count(lcd_dma, op.len, true);
+    lcd_sending = true;
 }
+
+#endif
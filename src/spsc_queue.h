@@ -0,0 +1,53 @@
+// spsc_queue.h - lock-free single-producer/single-consumer ring
+//
+// The producer only writes head, the consumer only writes tail, and each
+// publishes with a release store, so the two sides can sit on different cores
+// (or a task and an IRQ) without locks. Like FrameSwap it needs only atomic
+// loads/stores and has no Pico dependencies.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+template <typename T, int N>
+class SpscQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "queue size must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0), overflow(0) {}
+
+    // Producer side; returns false (and counts it) if the ring is full
+    bool push(const T &v) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= (uint32_t)N) {
+            overflow++;
+            return false;
+        }
+        buf[h & (N - 1)] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; returns false if empty
+    bool pop(T &v) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        v = buf[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+
+    // Pushes lost to a full ring (producer's count)
+    uint32_t dropped() const { return overflow; }
+
+private:
+    T buf[N];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    uint32_t overflow;
+};
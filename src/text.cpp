@@ -0,0 +1,197 @@
+// text.cpp - font, layout and bitmap cache
+
+#include "text.h"
+#include "game_classes.h"
+#include <cstring>
+
+// 5x7 font for printable ASCII (0x20..0x7E), indexed by ch - 0x20. Each glyph
+// is 5 cols, LSB top->bottom bits.
+static constexpr int FONT_FIRST = 0x20;
+static constexpr int FONT_COUNT = 0x7F - FONT_FIRST;
+static constexpr uint8_t FONT5x7[FONT_COUNT][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, // space
+    {0x00,0x00,0x5F,0x00,0x00}, // !
+    {0x00,0x07,0x00,0x07,0x00}, // "
+    {0x14,0x7F,0x14,0x7F,0x14}, // #
+    {0x24,0x2A,0x7F,0x2A,0x12}, // $
+    {0x23,0x13,0x08,0x64,0x62}, // %
+    {0x36,0x49,0x55,0x22,0x50}, // &
+    {0x00,0x05,0x03,0x00,0x00}, // '
+    {0x00,0x1C,0x22,0x41,0x00}, // (
+    {0x00,0x41,0x22,0x1C,0x00}, // )
+    {0x08,0x2A,0x1C,0x2A,0x08}, // *
+    {0x08,0x08,0x3E,0x08,0x08}, // +
+    {0x00,0x50,0x30,0x00,0x00}, // ,
+    {0x08,0x08,0x08,0x08,0x08}, // -
+    {0x00,0x60,0x60,0x00,0x00}, // .
+    {0x20,0x10,0x08,0x04,0x02}, // /
+    {0x3E,0x51,0x49,0x45,0x3E}, // 0
+    {0x00,0x42,0x7F,0x40,0x00}, // 1
+    {0x42,0x61,0x51,0x49,0x46}, // 2
+    {0x21,0x41,0x45,0x4B,0x31}, // 3
+    {0x18,0x14,0x12,0x7F,0x10}, // 4
+    {0x27,0x45,0x45,0x45,0x39}, // 5
+    {0x3C,0x4A,0x49,0x49,0x30}, // 6
+    {0x01,0x71,0x09,0x05,0x03}, // 7
+    {0x36,0x49,0x49,0x49,0x36}, // 8
+    {0x06,0x49,0x49,0x29,0x1E}, // 9
+    {0x00,0x36,0x36,0x00,0x00}, // :
+    {0x00,0x56,0x36,0x00,0x00}, // ;
+    {0x08,0x14,0x22,0x41,0x00}, // <
+    {0x14,0x14,0x14,0x14,0x14}, // =
+    {0x00,0x41,0x22,0x14,0x08}, // >
+    {0x02,0x01,0x51,0x09,0x06}, // ?
+    {0x32,0x49,0x79,0x41,0x3E}, // @
+    {0x7C,0x12,0x11,0x12,0x7C}, // A
+    {0x7F,0x49,0x49,0x49,0x36}, // B
+    {0x3E,0x41,0x41,0x41,0x22}, // C
+    {0x7F,0x41,0x41,0x22,0x1C}, // D
+    {0x7F,0x49,0x49,0x49,0x41}, // E
+    {0x7F,0x09,0x09,0x09,0x01}, // F
+    {0x3E,0x41,0x49,0x49,0x7A}, // G
+    {0x7F,0x08,0x08,0x08,0x7F}, // H
+    {0x00,0x41,0x7F,0x41,0x00}, // I
+    {0x20,0x40,0x41,0x3F,0x01}, // J
+    {0x7F,0x08,0x14,0x22,0x41}, // K
+    {0x7F,0x40,0x40,0x40,0x40}, // L
+    {0x7F,0x06,0x18,0x06,0x7F}, // M
+    {0x7F,0x06,0x18,0x60,0x7F}, // N
+    {0x3E,0x41,0x41,0x41,0x3E}, // O
+    {0x7F,0x09,0x09,0x09,0x06}, // P
+    {0x3E,0x41,0x51,0x21,0x5E}, // Q
+    {0x7F,0x09,0x19,0x29,0x46}, // R
+    {0x46,0x49,0x49,0x49,0x31}, // S
+    {0x01,0x01,0x7F,0x01,0x01}, // T
+    {0x3F,0x40,0x40,0x40,0x3F}, // U
+    {0x1F,0x20,0x40,0x20,0x1F}, // V
+    {0x7F,0x40,0x38,0x40,0x7F}, // W
+    {0x63,0x14,0x08,0x14,0x63}, // X
+    {0x07,0x08,0x70,0x08,0x07}, // Y
+    {0x61,0x51,0x49,0x45,0x43}, // Z
+    {0x00,0x7F,0x41,0x41,0x00}, // [
+    {0x02,0x04,0x08,0x10,0x20}, // backslash
+    {0x00,0x41,0x41,0x7F,0x00}, // ]
+    {0x04,0x02,0x01,0x02,0x04}, // ^
+    {0x40,0x40,0x40,0x40,0x40}, // _
+    {0x00,0x01,0x02,0x04,0x00}, // `
+    {0x20,0x54,0x54,0x54,0x78}, // a
+    {0x7F,0x48,0x44,0x44,0x38}, // b
+    {0x38,0x44,0x44,0x44,0x20}, // c
+    {0x38,0x44,0x44,0x48,0x7F}, // d
+    {0x38,0x54,0x54,0x54,0x18}, // e
+    {0x08,0x7E,0x09,0x01,0x02}, // f
+    {0x0C,0x52,0x52,0x52,0x3E}, // g
+    {0x7F,0x08,0x04,0x04,0x78}, // h
+    {0x00,0x44,0x7D,0x40,0x00}, // i
+    {0x20,0x40,0x44,0x3D,0x00}, // j
+    {0x7F,0x10,0x28,0x44,0x00}, // k
+    {0x00,0x41,0x7F,0x40,0x00}, // l
+    {0x7C,0x04,0x18,0x04,0x78}, // m
+    {0x7C,0x08,0x04,0x04,0x78}, // n
+    {0x38,0x44,0x44,0x44,0x38}, // o
+    {0x7C,0x14,0x14,0x14,0x08}, // p
+    {0x08,0x14,0x14,0x18,0x7C}, // q
+    {0x7C,0x08,0x04,0x04,0x08}, // r
+    {0x48,0x54,0x54,0x54,0x20}, // s
+    {0x04,0x3F,0x44,0x40,0x20}, // t
+    {0x3C,0x40,0x40,0x20,0x7C}, // u
+    {0x1C,0x20,0x40,0x20,0x1C}, // v
+    {0x3C,0x40,0x30,0x40,0x3C}, // w
+    {0x44,0x28,0x10,0x28,0x44}, // x
+    {0x0C,0x50,0x50,0x50,0x3C}, // y
+    {0x44,0x64,0x54,0x4C,0x44}, // z
+    {0x00,0x08,0x36,0x41,0x00}, // {
+    {0x00,0x00,0x7F,0x00,0x00}, // |
+    {0x00,0x41,0x36,0x08,0x00}, // }
+    {0x10,0x08,0x08,0x10,0x08}, // ~
+};
+
+static constexpr int PANEL = 32;
+static constexpr int GLYPH_H = 7;
+static constexpr int LINE_SPACING = 1;
+
+static const uint8_t *glyph(char ch) {
+    int i = (uint8_t)ch - FONT_FIRST;
+    if (i < 0 || i >= FONT_COUNT) i = 0; // fallback to space for unsupported
+    return FONT5x7[i];
+}
+
+// OR one line of glyphs into bm.rows[row0..row0+6] starting at panel column x
+static void raster_line(TextBitmap &bm, int row0, int x, const char *s, int len, int glyph_w) {
+    for (int i = 0; i < len; ++i, x += glyph_w) {
+        const uint8_t *g = glyph(s[i]);
+        for (int col = 0; col < glyph_w; ++col) {
+            int px = x + col;
+            if (px < 0 || px >= PANEL) continue;
+            uint8_t colbits = g[col];
+            for (int row = 0; row < GLYPH_H; ++row) {
+                if (colbits & (1 << row)) bm.rows[row0 + row] |= 1u << px;
+            }
+        }
+    }
+}
+
+void text_rasterize(TextBitmap &bm, const char *text, int y_off) {
+    memset(bm.rows, 0, sizeof(bm.rows));
+    int len = (int)strlen(text);
+    // no spacing between glyphs to maximize fit
+    int glyph_w = 5;
+    if (len * glyph_w > PANEL && len * 4 <= PANEL) glyph_w = 4;
+
+    if (len * glyph_w <= PANEL) {
+        bm.y = (PANEL - GLYPH_H) / 2 + y_off;
+        bm.h = GLYPH_H;
+        raster_line(bm, 0, (PANEL - len * glyph_w) / 2, text, len, glyph_w);
+        return;
+    }
+
+    // still too wide: split into two roughly-equal lines
+    int len1 = (len + 1) / 2;
+    int len2 = len - len1;
+    if (len1 * glyph_w > PANEL) glyph_w = 4;
+    bm.h = GLYPH_H * 2 + LINE_SPACING;
+    bm.y = (PANEL - bm.h) / 2 + y_off;
+    raster_line(bm, 0, (PANEL - len1 * glyph_w) / 2, text, len1, glyph_w);
+    raster_line(bm, GLYPH_H + LINE_SPACING, (PANEL - len2 * glyph_w) / 2, text + len1, len2, glyph_w);
+}
+
+// Overlay screens use a handful of fixed strings; keep the recent ones
+static const int TEXT_CACHE_SIZE = 8;
+static const int TEXT_KEY_LEN = 32;
+struct TextCacheEntry {
+    char text[TEXT_KEY_LEN];
+    int y_off;
+    uint32_t last_use; // 0 = empty
+    TextBitmap bm;
+};
+static TextCacheEntry text_cache[TEXT_CACHE_SIZE];
+static uint32_t text_cache_clock = 0;
+
+const TextBitmap &text_bitmap(const char *text, int y_off) {
+    // too long to be a key: rasterize every time rather than evict an entry
+    // it could never hit again
+    if (strlen(text) >= (size_t)TEXT_KEY_LEN) {
+        static TextBitmap scratch;
+        text_rasterize(scratch, text, y_off);
+        return scratch;
+    }
+    int victim = 0;
+    for (int i = 0; i < TEXT_CACHE_SIZE; ++i) {
+        TextCacheEntry &e = text_cache[i];
+        if (e.last_use && e.y_off == y_off && strcmp(e.text, text) == 0) {
+            e.last_use = ++text_cache_clock;
+            return e.bm;
+        }
+        if (e.last_use < text_cache[victim].last_use) victim = i;
+    }
+    TextCacheEntry &e = text_cache[victim];
+    strcpy(e.text, text);
+    e.y_off = y_off;
+    e.last_use = ++text_cache_clock;
+    text_rasterize(e.bm, text, y_off);
+    return e.bm;
+}
+
+void text_draw(Hub75Matrix &m, const TextBitmap &bm, uint8_t r, uint8_t g, uint8_t b) {
+    for (int i = 0; i < bm.h; ++i) m.set_row_mask(bm.y + i, bm.rows[i], r, g, b);
+}
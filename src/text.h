@@ -0,0 +1,28 @@
+// text.h - centered 5x7 text for the 32x32 panel
+//
+// A string is laid out and rasterized once into a TextBitmap (one 32-bit mask
+// per panel row) and kept in a small cache, so drawing it again is one masked
+// row write per text row instead of a glyph lookup per pixel.
+
+#pragma once
+
+#include <cstdint>
+
+class Hub75Matrix;
+
+struct TextBitmap {
+    static constexpr int MAX_ROWS = 15; // two 7-pixel lines + 1 spacing
+    int y;                    // panel row of rows[0]
+    int h;
+    uint32_t rows[MAX_ROWS];  // bit x set = pixel x lit
+};
+
+// Lay text out centered: one line with 5-column glyphs if it fits, else
+// 4-column (compact) glyphs, else two lines split in the middle
+void text_rasterize(TextBitmap &bm, const char *text, int y_off = 0);
+
+// Rasterized bitmap for (text, y_off), from the cache when possible. Text of
+// 32 characters or more isn't cached; its bitmap lasts until the next such call.
+const TextBitmap &text_bitmap(const char *text, int y_off = 0);
+
+void text_draw(Hub75Matrix &m, const TextBitmap &bm, uint8_t r, uint8_t g, uint8_t b);
@@ -0,0 +1,48 @@
+// tone_table.h - compile-time tone sequences for the audio sequencer
+//
+// Frequencies are turned into mixer phase steps and durations into
+// microseconds by the compiler, so a sequence is a const table in flash that
+// the sequencer walks by pointer; nothing is computed or copied when a sound
+// starts.
+
+#pragma once
+
+#include <cstdint>
+#include "audio_mixer.h"
+
+// One step of a sequence; step 0 is a rest
+struct Note {
+    uint32_t step;  // AudioMixer phase step per sample
+    uint32_t us;    // duration
+};
+
+constexpr Note note(uint32_t freq_hz, uint32_t ms) {
+    return { AudioMixer::phase_inc(freq_hz), ms * 1000 };
+}
+
+template <int N>
+struct NoteTable {
+    Note notes[N];
+    static constexpr int size() { return N; }
+};
+
+// Number of notes in a sweep from 'from' towards 'to' (inclusive) in 'by' Hz steps
+constexpr int sweep_len(int from, int to, int by) {
+    return (from > to ? from - to : to - from) / (by > 0 ? by : -by) + 1;
+}
+
+// N notes starting at 'from' Hz, 'by' Hz apart, 'ms' each
+template <int N>
+constexpr NoteTable<N> sweep(int from, int by, uint32_t ms) {
+    NoteTable<N> t{};
+    for (int i = 0; i < N; ++i) t.notes[i] = note((uint32_t)(from + by * i), ms);
+    return t;
+}
+
+template <int A, int B>
+constexpr NoteTable<A + B> concat(const NoteTable<A> &a, const NoteTable<B> &b) {
+    NoteTable<A + B> t{};
+    for (int i = 0; i < A; ++i) t.notes[i] = a.notes[i];
+    for (int i = 0; i < B; ++i) t.notes[A + i] = b.notes[i];
+    return t;
+}
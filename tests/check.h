@@ -0,0 +1,28 @@
+// check.h - minimal assertions for the host tests (ctest runs each binary)
+
+#pragma once
+
+#include <cstdio>
+
+static int check_failures = 0;
+
+// Report and count a failed condition; the test carries on
+#define CHECK(cond, ...)                                                   \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            check_failures++;                                              \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, #cond); \
+            fprintf(stderr, __VA_ARGS__);                                  \
+            fprintf(stderr, "\n");                                         \
+        }                                                                  \
+    } while (0)
+
+// main() returns this
+static inline int check_result(const char *name) {
+    if (check_failures) {
+        fprintf(stderr, "%s: %d check%s failed\n", name, check_failures, check_failures == 1 ? "" : "s");
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
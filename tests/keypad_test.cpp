@@ -0,0 +1,105 @@
+// keypad_test.cpp - KeypadScanner debounce, ghosting and queue on a simulated matrix
+//
+// Sweeps feed_column() the way the timer IRQ does, one column per
+// SCAN_PERIOD_US, from a 16-bit "keys held" mask.
+
+#include "keypad.h"
+#include "check.h"
+
+typedef KeypadScanner K;
+
+static uint32_t now_us = 0;
+
+// One full sweep with the keys in 'held' (bit row * COLS + col) down
+static void sweep(K &kp, uint16_t held) {
+    for (int c = 0; c < K::COLS; ++c) {
+        uint8_t rows = 0;
+        for (int r = 0; r < K::ROWS; ++r) {
+            if (held & (1u << (r * K::COLS + c))) rows |= (uint8_t)(1u << r);
+        }
+        now_us += K::SCAN_PERIOD_US;
+        kp.feed_column(c, rows, now_us);
+    }
+}
+
+static uint16_t bit(int row, int col) {
+    return (uint16_t)(1u << (row * K::COLS + col));
+}
+
+static int count_events(K &kp, KeyEvent *last = nullptr) {
+    int n = 0;
+    KeyEvent ev;
+    while (kp.pop(ev)) {
+        n++;
+        if (last) *last = ev;
+    }
+    return n;
+}
+
+static void test_debounce() {
+    K kp;
+    KeyEvent ev = {};
+    // contact bounce: on/off shorter than the debounce window never reports
+    for (int i = 0; i < 20; ++i) sweep(kp, (i & 1) ? 0 : bit(1, 3));
+    CHECK(count_events(kp) == 0, "bouncing key reported");
+
+    // held steady: one press, on the DEBOUNCE_SWEEPS-th sweep
+    for (int i = 1; i < K::DEBOUNCE_SWEEPS; ++i) sweep(kp, bit(1, 3));
+    CHECK(count_events(kp) == 0, "press reported before %d sweeps", K::DEBOUNCE_SWEEPS);
+    sweep(kp, bit(1, 3));
+    CHECK(count_events(kp, &ev) == 1 && ev.key == 'B' && ev.pressed && ev.time_us == now_us,
+          "expected one 'B' press at %u, got '%c' pressed=%d at %u", (unsigned)now_us, ev.key, ev.pressed,
+          (unsigned)ev.time_us);
+    CHECK(kp.is_down(1, 3), "B not down after its press");
+
+    // bounce on release keeps it down; a steady release reports once
+    for (int i = 0; i < 8; ++i) sweep(kp, (i % 3) ? 0 : bit(1, 3));
+    CHECK(count_events(kp) == 0 && kp.is_down(1, 3), "release bounce reported");
+    for (int i = 0; i < K::DEBOUNCE_SWEEPS; ++i) sweep(kp, 0);
+    CHECK(count_events(kp, &ev) == 1 && ev.key == 'B' && !ev.pressed, "expected one 'B' release");
+    CHECK(!kp.is_down(1, 3), "B still down after its release");
+}
+
+static void test_ghosting() {
+    K kp;
+    KeyEvent ev = {};
+    // three corners of a rectangle, then the fourth reads as pressed too
+    uint16_t three = bit(0, 0) | bit(0, 2) | bit(2, 0);
+    for (int i = 0; i < K::DEBOUNCE_SWEEPS; ++i) sweep(kp, three);
+    CHECK(count_events(kp) == 3, "expected the three real presses");
+    for (int i = 0; i < 3 * K::DEBOUNCE_SWEEPS; ++i) sweep(kp, three | bit(2, 2));
+    CHECK(count_events(kp) == 0 && !kp.is_down(2, 2), "ghost key '9' reported");
+
+    // once a corner lets go the fourth key is real
+    uint16_t two = bit(0, 0) | bit(2, 0) | bit(2, 2);
+    for (int i = 0; i < K::DEBOUNCE_SWEEPS; ++i) sweep(kp, two);
+    int n = 0;
+    bool saw_9 = false, saw_3_up = false;
+    while (kp.pop(ev)) {
+        n++;
+        saw_9 |= ev.key == '9' && ev.pressed;
+        saw_3_up |= ev.key == '3' && !ev.pressed;
+    }
+    CHECK(n == 2 && saw_9 && saw_3_up, "expected '3' released and '9' pressed, got %d events", n);
+}
+
+static void test_overflow() {
+    K kp;
+    // three rows pressed and released in turn without draining: 24 edges
+    // for 16 slots (one row at a time, so nothing is ghosted)
+    for (int r = 0; r < 3; ++r) {
+        for (int i = 0; i < K::DEBOUNCE_SWEEPS; ++i) sweep(kp, (uint16_t)(0xF << (r * K::COLS)));
+        for (int i = 0; i < K::DEBOUNCE_SWEEPS; ++i) sweep(kp, 0);
+    }
+    int n = count_events(kp);
+    CHECK(n == K::QUEUE_SIZE, "queue gave back %d events, holds %d", n, K::QUEUE_SIZE);
+    CHECK(kp.dropped() == (uint32_t)(3 * 2 * K::COLS - K::QUEUE_SIZE), "dropped %u",
+          (unsigned)kp.dropped());
+}
+
+int main() {
+    test_debounce();
+    test_ghosting();
+    test_overflow();
+    return check_result("keypad_test");
+}
@@ -0,0 +1,34 @@
+// lcd_text_test.cpp - LCD lines stay within 16 columns at the edges of their fields
+
+#include "lcd_text.h"
+#include "check.h"
+#include <climits>
+#include <cstring>
+
+static void expect_score(int score, int level, const char *want) {
+    char buf[32];
+    lcd_format_score(buf, sizeof(buf), score, level);
+    CHECK(strcmp(buf, want) == 0, "score %d level %d: \"%s\", want \"%s\"", score, level, buf, want);
+    CHECK(strlen(buf) <= 16, "score %d level %d: %zu columns", score, level, strlen(buf));
+}
+
+static void expect_status(int lives, const char *difficulty, int fps, const char *want) {
+    char buf[32];
+    lcd_format_status(buf, sizeof(buf), lives, difficulty, fps);
+    CHECK(strcmp(buf, want) == 0, "lives %d %s fps %d: \"%s\", want \"%s\"", lives, difficulty, fps, buf, want);
+    CHECK(strlen(buf) <= 16, "lives %d %s fps %d: %zu columns", lives, difficulty, fps, strlen(buf));
+}
+
+int main() {
+    expect_score(0, 1, "Lv01 Score:    0");
+    expect_score(99999, 99, "Lv99 Score:99999");
+    expect_score(100000, 99, "Lv99      100000");
+    expect_score(INT_MAX, 100, "Lv99  2147483647");
+    expect_score(-5, -1, "Lv00 Score:    0");
+
+    expect_status(3, "EASY", 60, "L3 EASY    60fps");
+    expect_status(9, "MEDIUM", 9999, "L9 MEDIUM9999fps");
+    expect_status(10, "MEDIUM", 10000, "L9 MEDIUM9999fps");
+    expect_status(-1, "NIGHTMARE", -3, "L0 NIGHTM   0fps");
+    return check_result("lcd_text_test");
+}
@@ -0,0 +1,165 @@
+// physics_test.cpp - swept collision stress at ball speeds above brick size
+//
+// Random brick fields, random ball positions and velocities of 2..7 px per
+// tick (bricks are 4x2), run through step_ball_swept for both scalars, with
+// and without the index. On every tick:
+//   - the ball doesn't end up overlapping a live brick
+//   - a tick with no impact doesn't pass through a live brick on the way
+//   - every brick killed is reported in brick_hits, once
+// The same path check is run over step_ball to make sure it does catch
+// tunnelling when there is some. A ball bouncing fast between two rows of
+// 1x1 bricks checks that more than four kills in one tick are all reported.
+
+#include "game_classes.h"
+#include "check.h"
+#include <cmath>
+
+static constexpr int W = 32, H = 32;
+static constexpr int BRICK_W = 4, BRICK_H = 2;
+static constexpr int COLS = 6, ROWS = 6;
+static constexpr int N = COLS * ROWS;
+static constexpr int TRIALS = 2000;
+static constexpr int TICKS = 100;
+static constexpr int PATH_SAMPLES = 64;
+static constexpr float TOUCH_EPS = 1e-3f;
+
+struct Rng {
+    uint64_t s;
+    uint32_t next() {
+        s = s * 6364136223846793005ull + 1442695040888963407ull;
+        return (uint32_t)(s >> 33);
+    }
+    float uniform() { return (float)(next() >> 8) * (1.0f / 16777216.0f); }
+};
+
+static bool overlaps(float x, float y, const Brick &b) {
+    return x + 2.0f > b.x + TOUCH_EPS && x < b.x + BRICK_W - TOUCH_EPS && y + 2.0f > b.y + TOUCH_EPS &&
+           y < b.y + BRICK_H - TOUCH_EPS;
+}
+
+static void make_field(Rng &rng, Brick *bricks) {
+    for (int r = 0; r < ROWS; ++r) {
+        for (int c = 0; c < COLS; ++c) {
+            Brick &b = bricks[r * COLS + c];
+            b.x = 1 + c * (BRICK_W + 1);
+            b.y = 1 + r * (BRICK_H + 1);
+            b.hits = 1;
+            b.alive = rng.next() % 10 < 7;
+            b.r = b.g = b.b = 0;
+        }
+    }
+}
+
+struct Counts {
+    long ticks;
+    long straight;   // ticks without an impact
+    long tunnels;
+    long max_hits;   // most bricks killed in one tick
+};
+
+template <typename S>
+static void run(bool swept, bool use_index, uint64_t seed, Counts &n) {
+    Rng rng = { seed };
+    Brick bricks[N];
+    BrickIndex index;
+    const PaddleBox floor_paddle = { 0, H - 2, W, 2 };
+
+    for (int trial = 0; trial < TRIALS; ++trial) {
+        make_field(rng, bricks);
+        index.build(bricks, N, BRICK_W, BRICK_H);
+        float speed = 2.0f + 5.0f * rng.uniform();
+        float angle = 6.2831853f * rng.uniform();
+        float vx = speed * cosf(angle), vy = speed * sinf(angle);
+        if (fabsf(vy) < 0.5f) vy = vy < 0 ? -0.5f : 0.5f;
+        BallState<S> ball = { S(1.0f + 28.0f * rng.uniform()), S(20.0f + 7.0f * rng.uniform()), S(vx), S(vy) };
+
+        for (int tick = 0; tick < TICKS; ++tick) {
+            bool alive[N];
+            for (int i = 0; i < N; ++i) alive[i] = bricks[i].alive;
+            float x0 = (float)ball.x, y0 = (float)ball.y;
+            float dx = (float)ball.vx, dy = (float)ball.vy;
+
+            StepResult res = swept
+                ? step_ball_swept(ball, W, H, floor_paddle, bricks, N, BRICK_W, BRICK_H, use_index ? &index : nullptr)
+                : step_ball(ball, W, H, floor_paddle, bricks, N, BRICK_W, BRICK_H, use_index ? &index : nullptr);
+            n.ticks++;
+
+            int killed = 0;
+            for (int i = 0; i < N; ++i) killed += alive[i] && !bricks[i].alive;
+            if (res.n_brick_hits > n.max_hits) n.max_hits = res.n_brick_hits;
+            if (swept) {
+                CHECK(killed == res.n_brick_hits, "trial %d tick %d: %d bricks killed, %d reported", trial, tick,
+                      killed, res.n_brick_hits);
+                for (int k = 0; k < res.n_brick_hits; ++k) {
+                    int b = res.brick_hits[k];
+                    CHECK(alive[b] && !bricks[b].alive, "trial %d tick %d: brick %d reported but not killed",
+                          trial, tick, b);
+                    for (int j = 0; j < k; ++j) CHECK(res.brick_hits[j] != b, "brick %d reported twice", b);
+                }
+                for (int i = 0; i < N; ++i) {
+                    CHECK(!bricks[i].alive || !overlaps((float)ball.x, (float)ball.y, bricks[i]),
+                          "trial %d tick %d: ball at %.3f,%.3f inside brick %d", trial, tick, (float)ball.x,
+                          (float)ball.y, i);
+                }
+            }
+
+            if (res.wall_bounces == 0 && !res.paddle_hit && res.n_brick_hits == 0 && !res.fell) {
+                n.straight++;
+                bool crossed = false;
+                for (int s = 1; s <= PATH_SAMPLES && !crossed; ++s) {
+                    float t = (float)s / PATH_SAMPLES;
+                    for (int i = 0; i < N && !crossed; ++i) {
+                        crossed = alive[i] && overlaps(x0 + dx * t, y0 + dy * t, bricks[i]);
+                    }
+                }
+                n.tunnels += crossed;
+            }
+            if (res.level_cleared || res.fell) break;
+        }
+    }
+}
+
+template <typename S>
+static void check_scalar(const char *name) {
+    for (int use_index = 0; use_index < 2; ++use_index) {
+        Counts swept = {}, step = {};
+        run<S>(true, use_index, 1, swept);
+        run<S>(false, use_index, 1, step);
+        printf("%s %s: swept %ld ticks (%ld straight), %ld tunnels, up to %ld hits/tick; step %ld tunnels\n",
+               name, use_index ? "index" : "scan", swept.ticks, swept.straight, swept.tunnels, swept.max_hits,
+               step.tunnels);
+        CHECK(swept.tunnels == 0, "%s: swept ball passed through %ld live bricks", name, swept.tunnels);
+        CHECK(step.tunnels > 0, "%s: the path check found no tunnelling in step_ball either", name);
+    }
+}
+
+// Two full rows of 1x1 bricks, 3 px apart, with the ball bouncing between
+// them at 12 px per tick: every impact kills a brick
+template <typename S>
+static void check_many_hits(const char *name) {
+    Brick bricks[2 * W];
+    for (int i = 0; i < 2 * W; ++i) {
+        bricks[i] = Brick();
+        bricks[i].x = i % W;
+        bricks[i].y = i < W ? 1 : 5;
+        bricks[i].alive = true;
+    }
+    BrickIndex index;
+    index.build(bricks, 2 * W, 1, 1);
+    const PaddleBox paddle = { 0, H - 2, W, 2 };
+    BallState<S> ball = { S(4.0f), S(2.5f), S(1.5f), S(12.0f) };
+    StepResult res = step_ball_swept(ball, W, H, paddle, bricks, 2 * W, 1, 1, &index);
+    int killed = 0;
+    for (const Brick &b : bricks) killed += !b.alive;
+    printf("%s: %d bricks killed in one tick, %d reported\n", name, killed, res.n_brick_hits);
+    CHECK(res.n_brick_hits > 4, "%s: only %d hits in the corridor", name, res.n_brick_hits);
+    CHECK(killed == res.n_brick_hits, "%s: %d bricks killed, %d reported", name, killed, res.n_brick_hits);
+}
+
+int main() {
+    check_many_hits<Fixed>("fixed corridor");
+    check_many_hits<float>("float corridor");
+    check_scalar<Fixed>("fixed");
+    check_scalar<float>("float");
+    return check_result("physics_test");
+}
@@ -0,0 +1,114 @@
+// replay_test.cpp - InputRecorder encoding replayed through InputReplay
+//
+// Plays a scripted session (a sweeping joystick, difficulty keys, restarts
+// after game over) long enough to wrap the ring, recording it the way the
+// device main loop does. Replaying what the ring kept must match every
+// keyframe and end in the recorded final state. Replaying with different
+// joystick tuning must not, so the keyframe check is known to bite.
+
+#include "input_record.h"
+#include "check.h"
+#include <cstring>
+
+static Hub75Matrix matrix;
+static constexpr int TICKS = 30000;
+static constexpr uint32_t TICK_MS = 10;
+static constexpr uint16_t CAL_CENTER = 2048 << 4, CAL_RANGE = 1800 << 4;
+
+// Triangle sweep over the whole stick range with an odd period, plus jitter
+static uint16_t scripted_reading(int tick) {
+    int phase = tick % 331;
+    int tri = phase < 166 ? phase : 331 - phase;                        // 0..165
+    int dev = (tri - 83) * (int)CAL_RANGE / 70 + (tick * 7919 % 97) - 48; // past both ends
+    int raw = CAL_CENTER + dev;
+    if (raw < 0) raw = 0;
+    if (raw > 0xFFFF) raw = 0xFFFF;
+    return (uint16_t)raw;
+}
+
+static void record_keyframe(InputRecorder &rec, uint32_t now, const BrickBreaker &g, const JoystickPaddle &joy) {
+    if (!rec.keyframe_due()) return;
+    InputKeyframe k;
+    input_keyframe(k, g, joy);
+    rec.keyframe(now, k);
+}
+
+static void press(InputRecorder &rec, uint32_t now, BrickBreaker &g, const JoystickPaddle &joy, char k) {
+    record_keyframe(rec, now, g, joy);
+    rec.key(now, k);
+    game_key(g, k);
+}
+
+static void drain(BrickBreaker &g) {
+    GameEvent ev;
+    while (g.events.pop(ev)) {}
+}
+
+// Replay into a fresh game; fills in its final keyframe
+static InputReplay::Stats replay(const InputRecorder &rec, const JoystickParams &params, InputKeyframe &end) {
+    static BrickBreaker game(matrix);
+    JoystickPaddle joy(params);
+    InputReplay r = rec.replay();
+    CHECK(r.begin(game, joy), "recording doesn't start with a keyframe");
+    uint16_t raw;
+    while (r.next_tick(game, joy, raw)) {
+        game_tick(game, joy, raw);
+        drain(game);
+    }
+    input_keyframe(end, game, joy);
+    return r.stats();
+}
+
+int main() {
+    static InputRecorder rec;
+    static BrickBreaker game(matrix);
+    JoystickPaddle joy;
+    joy.calibrate(CAL_CENTER, CAL_RANGE);
+    joy.reset(game.paddle_x);
+
+    uint32_t now = 0, last_ms = 0;
+    int restarts = 0, keys = 0;
+    for (int tick = 0; tick < TICKS; ++tick, now += TICK_MS) {
+        // a long pause now and then, for the escaped time delta
+        if (tick % 5000 == 4999) now += 2000;
+        if (game.is_game_over() || game.is_level_cleared()) {
+            press(rec, now, game, joy, 'B');
+            last_ms = now;
+            restarts++;
+            continue;
+        }
+        if (tick % 1237 == 0) {
+            press(rec, now, game, joy, "ACB"[tick / 1237 % 3]);
+            keys++;
+        }
+        uint16_t raw = scripted_reading(tick);
+        record_keyframe(rec, now, game, joy);
+        rec.joystick(now, raw);
+        last_ms = now;
+        game_tick(game, joy, raw);
+        drain(game);
+    }
+    InputKeyframe live;
+    input_keyframe(live, game, joy);
+
+    InputKeyframe end;
+    InputReplay::Stats st = replay(rec, joy.params, end);
+    printf("recorded %u bytes: %lu ticks, %lu keys, %lu keyframes (%d restarts, %d difficulty keys live)\n",
+           (unsigned)rec.size(), (unsigned long)st.ticks, (unsigned long)st.keys, (unsigned long)st.keyframes,
+           restarts, keys);
+    CHECK(restarts > 0, "script never lost a game");
+    CHECK(rec.size() > InputRecorder::RING_SIZE - 2 * InputRecorder::KEYFRAME_BYTES, "ring never filled");
+    CHECK(st.keyframes > 1 && st.keys > 0, "replay saw %lu keyframes, %lu keys", (unsigned long)st.keyframes,
+          (unsigned long)st.keys);
+    CHECK(st.diverged == 0, "%lu of %lu keyframes diverged", (unsigned long)st.diverged,
+          (unsigned long)st.keyframes);
+    CHECK(st.last_ms == last_ms, "replay ended at %lu ms, recording at %lu ms", (unsigned long)st.last_ms,
+          (unsigned long)last_ms);
+    CHECK(memcmp(&end, &live, sizeof(end)) == 0, "replay ended in a different state");
+
+    JoystickParams other = joy.params;
+    other.smooth *= 2.0f;
+    st = replay(rec, other, end);
+    CHECK(st.diverged > 0, "replay with other joystick tuning matched every keyframe");
+    return check_result("replay_test");
+}